@@ -25,6 +25,7 @@
 ThreadedKernel::ThreadedKernel(int argc, char **argv)
 {
     randomSlice = FALSE; 
+    tickless = FALSE;
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-rs") == 0) {
  	    ASSERT(i + 1 < argc);
@@ -32,8 +33,15 @@ ThreadedKernel::ThreadedKernel(int argc, char **argv)
 					// number generator
 	    randomSlice = TRUE;
 	    i++;
+        } else if (strcmp(argv[i], "-tickless") == 0) {
+            tickless = TRUE;
+        } else if (strcmp(argv[i], "-pool") == 0) {
+ 	    ASSERT(i + 1 < argc);
+            Thread::SetPoolLimit(atoi(argv[++i]));
         } else if (strcmp(argv[i], "-u") == 0) {
             cout << "Partial usage: nachos [-rs randomSeed]\n";
+            cout << "Partial usage: nachos [-tickless]\n";
+            cout << "Partial usage: nachos [-pool threads] (finished threads to keep)\n";
 	}
     }
 }
@@ -51,9 +59,9 @@ ThreadedKernel::Initialize()
     stats = new Statistics();		// collect statistics
     interrupt = new Interrupt;		// start up interrupt handling
     scheduler = new Scheduler();	// initialize the ready queue
-    alarm = new Alarm(randomSlice);	// start up time slicing
+    alarm = new Alarm(randomSlice, tickless);	// start up time slicing
 
-    usedPhysPages[NumPhysPages] = {FALSE};
+    usedPhysPages = NULL;
 
     // We didn't explicitly allocate the current thread we are running in.
     // But if it ever tries to give up the CPU, we better have a Thread
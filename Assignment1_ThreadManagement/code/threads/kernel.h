@@ -43,10 +43,12 @@ class ThreadedKernel {
     Statistics *stats;		// performance metrics
     Alarm *alarm;		// the software alarm clock
  
-    bool usedPhysPages[NumPhysPages];
+    bool *usedPhysPages;	// which physical pages hold a program;
+				// allocated by the first AddrSpace
 
   private:
     bool randomSlice;		// enable pseudo-random time slicing
+    bool tickless;		// have the timer go off only when needed
 };
 
 
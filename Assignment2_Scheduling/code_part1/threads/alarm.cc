@@ -18,17 +18,20 @@
 //
 //      "doRandom" -- if true, arrange for the hardware interrupts to 
 //		occur at random, instead of fixed, intervals.
+//      "tickless" -- if true, have the hardware interrupt only when
+//		we need it to.
 //----------------------------------------------------------------------
 
-Alarm::Alarm(bool doRandom)
+Alarm::Alarm(bool doRandom, bool tickless)
 {
-    timer = new Timer(doRandom, this);
+    timer = new Timer(doRandom, this, tickless);
 }
 
 //----------------------------------------------------------------------
 // Alarm::CallBack
 //	Software interrupt handler for the timer device. The timer device is
-//	set up to interrupt the CPU periodically (once every TimerTicks).
+//	set up to interrupt the CPU periodically (once every TimerTicks),
+//	or in tickless mode, when Rearm asks it to.
 //	This routine is called each time there is a timer interrupt,
 //	with interrupts disabled.
 //
@@ -53,14 +56,16 @@ Alarm::CallBack()
     MachineStatus status = interrupt->getStatus();
     
     bool noOneSleeping = kernel->scheduler->NoOneSleeping();
+    bool sliceOver = (timer->CountTicks() > 0);
     kernel->scheduler->AlarmTicks();
     if (status == IdleMode && noOneSleeping) {  // is it time to quit?
         if (!interrupt->AnyFutureInterrupts()) {
 	    timer->Disable();	// turn off the timer
 	}
-    } else {			// there's someone to preempt
+    } else if (sliceOver) {	// there's someone to preempt
 	interrupt->YieldOnReturn();
     }
+    Rearm();			// in case we are tickless
 }
 
 void
@@ -74,3 +79,42 @@ Alarm::WaitUntil(int x)
     (void) interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// Alarm::WaitTicks
+//	Suspend the current thread for at least "n" ticks.  Unlike
+//	WaitUntil, "n" need not be whole time slices; but only a tickless
+//	timer will wake it up before the end of the time slice it is due in.
+//----------------------------------------------------------------------
+
+void
+Alarm::WaitTicks(Ticks n)
+{
+    Interrupt *interrupt = kernel->interrupt;
+    
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);  
+    kernel->scheduler->SleepUntil(kernel->stats->totalTicks + n);
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Alarm::Rearm
+//	In tickless mode, arrange for the timer to go off when the
+//	scheduler next needs it.  Called after each timer interrupt, and
+//	whenever that may have become sooner: a thread was made ready,
+//	or went to sleep.  Interrupts are disabled.
+//
+//	Sleeping threads are woken up at the exact tick they are due,
+//	which need not be the end of a time slice.
+//----------------------------------------------------------------------
+
+void
+Alarm::Rearm()
+{
+    Scheduler *scheduler = kernel->scheduler;
+
+    if (!timer->IsTickless())
+	return;
+    timer->WakeAfter(scheduler->TicksNeeded());
+    if (!scheduler->NoOneSleeping())
+	timer->WakeAt(scheduler->NextWakeup());
+}
@@ -24,10 +24,12 @@
 #include "main.h"
 
 static int 
-SleepTimeCompare(SleepingThread *x, SleepingThread *y) 
+WakeTimeCompare(SleepingThread *x, SleepingThread *y) 
 {
-    if (x->sleepTime < y->sleepTime) { return -1; }
-    else if (x->sleepTime > y->sleepTime) { return 1; }
+    if (x->wakeTime < y->wakeTime) { return -1; }
+    else if (x->wakeTime > y->wakeTime) { return 1; }
+    else if (x->order < y->order) { return -1; }
+    else if (x->order > y->order) { return 1; }
     else { return 0; }
 }
 
@@ -40,9 +42,10 @@ SleepTimeCompare(SleepingThread *x, SleepingThread *y)
 Scheduler::Scheduler()
 {
 //	schedulerType = type;
-	readyList = new List<Thread *>; 
+	readyList = new ThreadQueue; 
 	toBeDestroyed = NULL;
-    sleepingList = new SortedList<SleepingThread *>(SleepTimeCompare);
+    sleepingHeap = new Heap<SleepingThread *>(WakeTimeCompare);
+    numSlept = 0;
 } 
 
 //----------------------------------------------------------------------
@@ -53,10 +56,10 @@ Scheduler::Scheduler()
 Scheduler::~Scheduler()
 { 
     delete readyList; 
-    while (!sleepingList->IsEmpty()) {
-	delete sleepingList->RemoveFront();
+    while (!sleepingHeap->IsEmpty()) {
+	delete sleepingHeap->RemoveFront();
     }
-    delete sleepingList;
+    delete sleepingHeap;
 } 
 
 //----------------------------------------------------------------------
@@ -75,6 +78,7 @@ Scheduler::ReadyToRun (Thread *thread)
 
     thread->setStatus(READY);
     readyList->Append(thread);
+    kernel->alarm->Rearm();		// it may need a time slice
 }
 
 //----------------------------------------------------------------------
@@ -199,38 +203,102 @@ Scheduler::Print()
 }
 
 
+//----------------------------------------------------------------------
+// Scheduler::SetToSleep
+// 	Put the current thread to sleep for "sleepTime" time slices,
+//	counting the current one: that is, until the end of the
+//	"sleepTime"th time slice from the start of the current one.
+//	At least until the end of the current one.
+//----------------------------------------------------------------------
+
 void
 Scheduler::SetToSleep(int sleepTime)
+{
+    if (sleepTime < 1)
+        sleepTime = 1;
+    SleepUntil(kernel->alarm->SliceStart() + (Ticks) sleepTime * TimerTicks);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SleepUntil
+// 	Put the current thread to sleep until time "when", at the
+//	latest the first timer interrupt after it.  Sleeping threads
+//	are kept on a heap by when they are due, so that a timer
+//	interrupt only needs to look at the ones to wake up.
+//----------------------------------------------------------------------
+
+void
+Scheduler::SleepUntil(Ticks when)
 {
     Thread* sleepyThread = kernel->currentThread;
     
     ASSERT(kernel->interrupt->getLevel() == IntOff);
     
-    SleepingThread* toSleep = new SleepingThread(sleepyThread, sleepTime);
-    sleepingList->Insert(toSleep); // insert the thread in sorted order
+    sleepingHeap->Insert(new SleepingThread(sleepyThread, when, numSlept++));
+    kernel->alarm->Rearm(); // we may need to wake up before anyone else
     sleepyThread->Sleep(FALSE);
 }
 
+//----------------------------------------------------------------------
+// Scheduler::AlarmTicks
+// 	Called on a timer interrupt: wake up every sleeping thread that
+//	is due by now, the first due first.
+//
+//	They are all taken off the heap before any is made ready, so
+//	that the timer isn't re-armed for the ones still on it.
+//----------------------------------------------------------------------
+
 void
 Scheduler::AlarmTicks()
 {
-    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    Ticks now = kernel->stats->totalTicks;
+    ThreadQueue wokenThreads;
+    SleepingThread *woken;
     
-    ListIterator<SleepingThread *> iter(sleepingList); 
-    for (; !iter.IsDone(); iter.Next()) {
-        iter.Item()->sleepTime --; // update the remaining sleeping time
-    }
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
     
-    while (!NoOneSleeping()) {
-        if (sleepingList->Front()->sleepTime > 0) break;
-                    // if the first thread in the sorted list is still sleeping,
-                    // other threads must still be sleeping
-        ReadyToRun(sleepingList->RemoveFront()->sleeper);
+    while (!NoOneSleeping() && sleepingHeap->Front()->wakeTime <= now) {
+        woken = sleepingHeap->RemoveFront();
+        wokenThreads.Append(woken->sleeper);
+        delete woken;
     }
+    while (!wokenThreads.IsEmpty())
+        ReadyToRun(wokenThreads.RemoveFront());
 }
 
 bool 
 Scheduler::NoOneSleeping()
 { 
-    return sleepingList->IsEmpty(); 
+    return sleepingHeap->IsEmpty(); 
 };
+
+Ticks
+Scheduler::NextWakeup()
+{
+    return sleepingHeap->Front()->wakeTime;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::TicksNeeded
+// 	Return at the end of which time slice, counting from the last
+//	one the timer counted, the timer next needs to go off; 0 if it
+//	doesn't.  Only used in tickless mode (see Alarm::Rearm).
+//
+//	We need it at the end of the current slice if there is a ready
+//	thread to preempt the current one with.  When the CPU is idle,
+//	the first ready thread will just be run, so it needs another one
+//	to compete with.  (Sleeping threads need it at the exact time
+//	they are due instead; see NextWakeup.)
+//----------------------------------------------------------------------
+
+long long
+Scheduler::TicksNeeded()
+{
+    unsigned int competing = 
+        (kernel->interrupt->getStatus() == IdleMode) ? 2 : 1;
+    long long ticks = 0;
+    
+    if (readyList->NumInList() >= competing)
+        ticks = 1;
+    return ticks;
+}
@@ -12,14 +12,18 @@
 #include "copyright.h"
 #include "list.h"
 #include "thread.h"
+#include "stats.h"
+#include "heap.h"
 
 class SleepingThread {
     public:
-        SleepingThread(Thread* t, int x)
-            : sleeper(t), sleepTime(x) {};
+        SleepingThread(Thread* t, Ticks when, unsigned long long n)
+            : sleeper(t), wakeTime(when), order(n) {};
         
         Thread* sleeper;
-        int sleepTime; // the remaining sleeping time
+        Ticks wakeTime; // when to wake up, in ticks since Nachos started
+        unsigned long long order; // which one went to sleep first, among
+                                  // those with the same wakeTime
 };
 
 // The following class defines the scheduler/dispatcher abstraction -- 
@@ -48,22 +52,29 @@ class Scheduler {
 	void Print();			// Print contents of ready list
     
     void SetToSleep(int sleepTime); 
-                    // insert the thread to the sleepingList
+                    // put the current thread to sleep for sleepTime
+                    // time slices
+    void SleepUntil(Ticks when);
+                    // put the current thread to sleep until time "when"
     void AlarmTicks();
-                    // minus sleepTime by 1 for each sleeping thread
-                    // if some thread should wake up now, do so
-    bool NoOneSleeping(); // return TRUE if sleepingList is empty
+                    // wake up the sleeping threads that are due by now
+    bool NoOneSleeping(); // return TRUE if sleepingHeap is empty
+    Ticks NextWakeup(); // when the first sleeping thread is due
+    long long TicksNeeded(); // whether the timer needs to go off at the end
+                             // of this time slice
 
     // SelfTest for scheduler is implemented in class Thread
     
   private:
 	SchedulerType schedulerType;
-	List<Thread *> *readyList;	// queue of threads that are ready to run,
+	ThreadQueue *readyList;	// queue of threads that are ready to run,
 					// but not running
 	Thread *toBeDestroyed;		// finishing thread to be destroyed
     					// by the next thread that runs
 
-    SortedList<SleepingThread *> *sleepingList;
+    Heap<SleepingThread *> *sleepingHeap;
+                    // sleeping threads, the first one due first
+    unsigned long long numSlept; // how many times a thread went to sleep
 };
 
 #endif // SCHEDULER_H
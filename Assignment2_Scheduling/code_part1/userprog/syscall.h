@@ -31,6 +31,7 @@
 #define SC_ThreadYield	10
 #define SC_PrintInt	11
 #define SC_Sleep	12
+#define SC_SetTickets	13
 
 #ifndef IN_ASM
 
@@ -132,6 +133,11 @@ void PrintInt(int number);	//my System Call
 
 void Sleep(int time);	//sleep a thread for a specified amount of time
 
+/* Set how many tickets the calling thread holds (at least 1): under
+ * stride scheduling, its share of the CPU is in proportion to them.
+ */
+void SetTickets(int tickets);
+
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */
@@ -0,0 +1,9 @@
+#include "syscall.h"
+main()
+	{
+		int	i, j, k;
+		for (i=0;i<10;i++) {
+			for (j=0;j<2000;j++) k=k+j;
+			PrintInt(100+i);
+		}
+	}
@@ -0,0 +1,10 @@
+#include "syscall.h"
+main()
+	{
+		int	i, j, k;
+		SetTickets(300);
+		for (i=0;i<10;i++) {
+			for (j=0;j<2000;j++) k=k+j;
+			PrintInt(200+i);
+		}
+	}
@@ -18,17 +18,20 @@
 //
 //      "doRandom" -- if true, arrange for the hardware interrupts to 
 //		occur at random, instead of fixed, intervals.
+//      "tickless" -- if true, have the hardware interrupt only when
+//		we need it to.
 //----------------------------------------------------------------------
 
-Alarm::Alarm(bool doRandom)
+Alarm::Alarm(bool doRandom, bool tickless)
 {
-    timer = new Timer(doRandom, this);
+    timer = new Timer(doRandom, this, tickless);
 }
 
 //----------------------------------------------------------------------
 // Alarm::CallBack
 //	Software interrupt handler for the timer device. The timer device is
-//	set up to interrupt the CPU periodically (once every TimerTicks).
+//	set up to interrupt the CPU periodically (once every TimerTicks),
+//	or in tickless mode, when Rearm asks it to.
 //	This routine is called each time there is a timer interrupt,
 //	with interrupts disabled.
 //
@@ -53,16 +56,22 @@ Alarm::CallBack()
     MachineStatus status = interrupt->getStatus();
     
     bool noOneSleeping = kernel->scheduler->NoOneSleeping();
+    long long slices = timer->CountTicks();
     kernel->scheduler->AlarmTicks();
     kernel->scheduler->AccumNewBurst();
+    kernel->scheduler->UseSlices(slices);
     if (status == IdleMode && noOneSleeping) {  // is it time to quit?
-        if (!interrupt->AnyFutureInterrupts())
+        if (!interrupt->AnyFutureInterrupts() &&
+            kernel->scheduler->NumReady() == 0)
 	        timer->Disable();	// turn off the timer
-    } else {			// there's someone to preempt
-        if (kernel->scheduler->GetSchedulerType() == RR ||
-            kernel->scheduler->GetSchedulerType() == SJF)
+                        // (an interrupt due at the same time may have
+                        // just made a thread ready, which the idle
+                        // loop is about to run)
+    } else if (slices > 0) {	// there's someone to preempt
+        if (kernel->scheduler->ShouldPreempt())
 	        interrupt->YieldOnReturn();
     }
+    Rearm();			// in case we are tickless
 }
 
 void
@@ -76,3 +85,42 @@ Alarm::WaitUntil(int x)
     (void) interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// Alarm::WaitTicks
+//	Suspend the current thread for at least "n" ticks.  Unlike
+//	WaitUntil, "n" need not be whole time slices; but only a tickless
+//	timer will wake it up before the end of the time slice it is due in.
+//----------------------------------------------------------------------
+
+void
+Alarm::WaitTicks(Ticks n)
+{
+    Interrupt *interrupt = kernel->interrupt;
+    
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);  
+    kernel->scheduler->SleepUntil(kernel->stats->totalTicks + n);
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Alarm::Rearm
+//	In tickless mode, arrange for the timer to go off when the
+//	scheduler next needs it.  Called after each timer interrupt, and
+//	whenever that may have become sooner: a thread was made ready,
+//	or went to sleep.  Interrupts are disabled.
+//
+//	Sleeping threads are woken up at the exact tick they are due,
+//	which need not be the end of a time slice.
+//----------------------------------------------------------------------
+
+void
+Alarm::Rearm()
+{
+    Scheduler *scheduler = kernel->scheduler;
+
+    if (!timer->IsTickless())
+	return;
+    timer->WakeAfter(scheduler->TicksNeeded());
+    if (!scheduler->NoOneSleeping())
+	timer->WakeAt(scheduler->NextWakeup());
+}
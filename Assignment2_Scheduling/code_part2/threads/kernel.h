@@ -43,12 +43,19 @@ class ThreadedKernel {
     Statistics *stats;		// performance metrics
     Alarm *alarm;		// the software alarm clock
  
-    bool usedPhysPages[NumPhysPages];
+    bool *usedPhysPages;	// which physical pages hold a program;
+				// allocated by the first AddrSpace
 
   private:
     bool randomSlice;		// enable pseudo-random time slicing
+    bool tickless;		// have the timer go off only when needed
     
     SchedulerType schedulerType;
+    int mlfqLevels;		// for -MLFQ: how many queues, 0 for
+				// the default
+    int mlfqQuanta[NumPriorities]; // the quantum of each, in time slices
+    int mlfqBoost;		// time slices between priority boosts,
+				// 0 for the default
 };
 
 
@@ -22,39 +22,90 @@
 #include "debug.h"
 #include "scheduler.h"
 #include "main.h"
+#include <strings.h>
 
 static int 
-SleepTimeCompare(SleepingThread *x, SleepingThread *y) 
+WakeTimeCompare(SleepingThread *x, SleepingThread *y) 
 {
-    if (x->sleepTime < y->sleepTime) { return -1; }
-    else if (x->sleepTime > y->sleepTime) { return 1; }
+    if (x->wakeTime < y->wakeTime) { return -1; }
+    else if (x->wakeTime > y->wakeTime) { return 1; }
+    else if (x->order < y->order) { return -1; }
+    else if (x->order > y->order) { return 1; }
     else { return 0; }
 }
 
 static int 
 BurstTimeCompare(Thread *x, Thread *y)
 {
-    int xBurstTime = kernel->scheduler->GetRestBurstTime(x);
-    int yBurstTime = kernel->scheduler->GetRestBurstTime(y);
+    Ticks xBurstTime = kernel->scheduler->GetRestBurstTime(x);
+    Ticks yBurstTime = kernel->scheduler->GetRestBurstTime(y);
     if (xBurstTime < yBurstTime) { return -1; }
     else if (xBurstTime > yBurstTime) { return 1; }
+    else if (x->readyOrder < y->readyOrder) { return -1; }
+    else if (x->readyOrder > y->readyOrder) { return 1; }
     else { return 0; }
 }
 
+static int 
+PassCompare(Thread *x, Thread *y)
+{
+    if (x->pass < y->pass) { return -1; }
+    else if (x->pass > y->pass) { return 1; }
+    else if (x->readyOrder < y->readyOrder) { return -1; }
+    else if (x->readyOrder > y->readyOrder) { return 1; }
+    else { return 0; }
+}
+
+static void
+ReadyPlaced(Thread *thread, int i)
+{
+    thread->readyIndex = i;
+}
+
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
 // 	Initialize the list of ready but not running threads.
 //	Initially, no ready threads.
+//
+//	For the multi-level feedback queue, "levels" is how many queues
+//	there are, "quanta" the quantum of each, and "boost" how often
+//	every thread is moved back to the top queue, in time slices.
+//	If "levels" is 0, use the defaults.
 //----------------------------------------------------------------------
 
-Scheduler::Scheduler(SchedulerType type)
+Scheduler::Scheduler(SchedulerType type, int levels, int *quanta, int boost)
 {
     schedulerType = type;
-	if (type == RR || type == FCFS ) readyList = new List<Thread *>; 
-    else readyList = new SortedList<Thread *>(BurstTimeCompare); 
+    readyList = NULL;
+    readyHeap = NULL;
+    readyQueues = NULL;
+	if (type == RR || type == FCFS ) readyList = new ThreadQueue; 
+    else if (type == Priority || type == MLFQ) readyQueues = new PriorityQueues;
+    else if (type == Stride) readyHeap = new Heap<Thread *>(PassCompare, ReadyPlaced);
+    else readyHeap = new Heap<Thread *>(BurstTimeCompare, ReadyPlaced);
 	toBeDestroyed = NULL;
-    sleepingList = new SortedList<SleepingThread *>(SleepTimeCompare);
-    burstTimeMap = new std::map<Thread*, std::pair<int, int> >;
+    sleepingHeap = new Heap<SleepingThread *>(WakeTimeCompare);
+    numSlept = 0;
+    numReadied = 0;
+    startTicks = 0;
+    
+    ASSERT(levels >= 0 && levels <= NumPriorities);
+    numLevels = (levels > 0) ? levels : DefaultMLFQLevels;
+    for (int i = 0; i < numLevels; i++) {
+        quantum[i] = (levels > 0) ? quanta[i] : (DefaultMLFQQuantum << i);
+        ASSERT(quantum[i] > 0);
+        numDispatched[i] = totalResponse[i] = maxResponse[i] = 0;
+    }
+    boostPeriod = (boost > 0) ? boost : DefaultMLFQBoost;
+    lastBoost = 0;
+    numBoosts = 0;
+    quantumExpired = FALSE;
+
+    shares = new List<StrideShare *>;
+    competingTickets = 0;
+    dueSoFar = 0;
+    lastCharged = 0;
+    globalPass = 0;
 } 
 
 //----------------------------------------------------------------------
@@ -64,12 +115,21 @@ Scheduler::Scheduler(SchedulerType type)
 
 Scheduler::~Scheduler()
 { 
+    if (schedulerType == MLFQ)
+        PrintResponseTimes();
+    if (schedulerType == Stride)
+        PrintShares();
     delete readyList; 
-    while (!sleepingList->IsEmpty()) {
-	delete sleepingList->RemoveFront();
+    delete readyHeap;
+    delete readyQueues;
+    while (!sleepingHeap->IsEmpty()) {
+	delete sleepingHeap->RemoveFront();
+    }
+    delete sleepingHeap;
+    while (!shares->IsEmpty()) {
+	delete shares->RemoveFront();
     }
-    delete sleepingList;
-    delete burstTimeMap;
+    delete shares;
 } 
 
 //----------------------------------------------------------------------
@@ -87,11 +147,29 @@ Scheduler::ReadyToRun (Thread *thread)
     DEBUG(dbgThread, "Putting thread on ready list: " << thread->getName());
 
     thread->setStatus(READY);
-    if (burstTimeMap->find(thread) == burstTimeMap->end())
-                                    // thread not in map yet
-        (*burstTimeMap)[thread] = std::make_pair(0, 0);
-                                    // initialize the CPU burst time to 0
+    if (schedulerType == Priority) {    // no burst times to keep
+        readyQueues->Append(thread, thread->getPriority());
+        kernel->alarm->Rearm();
+        return;
+    }
+    if (schedulerType == MLFQ) {        // nor here
+        thread->readySince = kernel->stats->totalTicks;
+        readyQueues->Append(thread, LevelOf(thread));
+        kernel->alarm->Rearm();
+        return;
+    }
+    if (schedulerType == Stride) {
+        Charge();                   // if it is the running thread
+        StartCompeting(thread);
+    }
+    if (readyHeap != NULL) {
+        thread->readyOrder = numReadied++;
+        readyHeap->Insert(thread);
+    } else
 	readyList->Append(thread);
+    if (schedulerType == SJF && ShouldPreemptFor(thread))
+        kernel->interrupt->YieldWhenEnabled();
+    kernel->alarm->Rearm();		// it may need a time slice
 }
 
 //----------------------------------------------------------------------
@@ -107,7 +185,11 @@ Scheduler::FindNextToRun ()
 {
     ASSERT(kernel->interrupt->getLevel() == IntOff);
 
-    if (readyList->IsEmpty()) {
+    if (readyQueues != NULL) {
+	return readyQueues->RemoveFront();
+    } else if (readyHeap != NULL) {
+	return readyHeap->IsEmpty() ? NULL : readyHeap->RemoveFront();
+    } else if (readyList->IsEmpty()) {
 	return NULL;
     } else {
     	return readyList->RemoveFront();
@@ -145,6 +227,8 @@ Scheduler::Run (Thread *nextThread, bool finishing)
 	    toBeDestroyed = oldThread;
         Account(); // account the burst time of the thread going to finish
     }
+    if (schedulerType == MLFQ || schedulerType == Stride)
+        Switching(oldThread, nextThread, finishing);
     
 #ifdef USER_PROGRAM			// ignore until running user programs 
     if (oldThread->space != NULL) {	// if this thread is a user program,
@@ -208,18 +292,48 @@ Scheduler::CheckToBeDestroyed()
 //----------------------------------------------------------------------
 // Scheduler::Print
 // 	Print the scheduler state -- in other words, the contents of
-//	the ready list.  For debugging.
+//	the ready list.  For debugging.  (The ready heap of SJF is
+//	printed in no particular order.)
 //----------------------------------------------------------------------
 void
 Scheduler::Print()
 {
     cout << "Ready list contents:\n";
-    readyList->Apply(ThreadPrint);
+    if (readyQueues != NULL)
+        readyQueues->Apply(ThreadPrint);
+    else if (readyHeap != NULL)
+        readyHeap->Apply(ThreadPrint);
+    else
+        readyList->Apply(ThreadPrint);
 }
 
 
+//----------------------------------------------------------------------
+// Scheduler::SetToSleep
+// 	Put the current thread to sleep for "sleepTime" time slices,
+//	counting the current one: that is, until the end of the
+//	"sleepTime"th time slice from the start of the current one.
+//	At least until the end of the current one.
+//----------------------------------------------------------------------
+
 void
 Scheduler::SetToSleep(int sleepTime)
+{
+    if (sleepTime < 1)
+        sleepTime = 1;
+    SleepUntil(kernel->alarm->SliceStart() + (Ticks) sleepTime * TimerTicks);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SleepUntil
+// 	Put the current thread to sleep until time "when", at the
+//	latest the first timer interrupt after it.  Sleeping threads
+//	are kept on a heap by when they are due, so that a timer
+//	interrupt only needs to look at the ones to wake up.
+//----------------------------------------------------------------------
+
+void
+Scheduler::SleepUntil(Ticks when)
 {
     Thread* sleepyThread = kernel->currentThread;
     
@@ -227,62 +341,194 @@ Scheduler::SetToSleep(int sleepTime)
     
     Account(); // account the burst time of the thread going to sleep
     
-    SleepingThread* toSleep = new SleepingThread(sleepyThread, sleepTime);
-    sleepingList->Insert(toSleep); // insert the thread in sorted order
+    sleepingHeap->Insert(new SleepingThread(sleepyThread, when, numSlept++));
+    kernel->alarm->Rearm(); // we may need to wake up before anyone else
     sleepyThread->Sleep(FALSE);
 }
 
+//----------------------------------------------------------------------
+// Scheduler::AlarmTicks
+// 	Called on a timer interrupt: wake up every sleeping thread that
+//	is due by now, the first due first.
+//
+//	They are all taken off the heap before any is made ready, so
+//	that the timer isn't re-armed for the ones still on it.
+//----------------------------------------------------------------------
+
 void
 Scheduler::AlarmTicks()
 {
-    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    Ticks now = kernel->stats->totalTicks;
+    ThreadQueue wokenThreads;
+    SleepingThread *woken;
     
-    ListIterator<SleepingThread *> iter(sleepingList); 
-    for (; !iter.IsDone(); iter.Next()) {
-        iter.Item()->sleepTime --; // update the remaining sleeping time
-    }
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
     
-    while (!NoOneSleeping()) {
-        if (sleepingList->Front()->sleepTime > 0) break;
-                    // if the first thread in the sorted list is still sleeping,
-                    // other threads must still be sleeping
-        ReadyToRun(sleepingList->RemoveFront()->sleeper);
+    while (!NoOneSleeping() && sleepingHeap->Front()->wakeTime <= now) {
+        woken = sleepingHeap->RemoveFront();
+        wokenThreads.Append(woken->sleeper);
+        delete woken;
     }
+    while (!wokenThreads.IsEmpty())
+        ReadyToRun(wokenThreads.RemoveFront());
 }
 
 bool 
 Scheduler::NoOneSleeping()
 { 
-    return sleepingList->IsEmpty(); 
+    return sleepingHeap->IsEmpty(); 
 };
 
-int
+Ticks
+Scheduler::NextWakeup()
+{
+    return sleepingHeap->Front()->wakeTime;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::TicksNeeded
+// 	Return at the end of which time slice, counting from the last
+//	one the timer counted, the timer next needs to go off; 0 if it
+//	doesn't.  Only used in tickless mode (see Alarm::Rearm).
+//
+//	We need it at the end of the current slice if there is a ready
+//	thread to preempt the current one with.  When the CPU is idle,
+//	the first ready thread will just be run, so it needs another one
+//	to compete with.  (Sleeping threads need it at the exact time
+//	they are due instead; see NextWakeup.)
+//----------------------------------------------------------------------
+
+long long
+Scheduler::TicksNeeded()
+{
+    unsigned int competing = 
+        (kernel->interrupt->getStatus() == IdleMode) ? 2 : 1;
+    long long ticks = 0;
+    Thread *thread = kernel->currentThread;
+    
+    if (NumReady() >= competing &&
+        (schedulerType == RR || schedulerType == SJF ||
+         schedulerType == Priority || schedulerType == Stride))
+        ticks = 1;
+    if (NumReady() >= competing && schedulerType == MLFQ) {
+        if (competing == 2 || 
+            readyQueues->HighestPriority() < LevelOf(thread))
+            ticks = 1;      // don't know yet who will run; or to preempt
+        else                // when its quantum is up
+            ticks = max(quantum[LevelOf(thread)] - thread->quantumUsed, 1LL);
+    }
+    return ticks;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ShouldPreempt
+// 	Return whether the current thread should give up the CPU at the
+//	end of its time slice.  Round robin and preemptive SJF always
+//	switch, if there is any thread to switch to.  The priority
+//	scheduler only switches to a thread of the same or a higher
+//	priority: a lower one has to wait until the CPU is given up.
+//	The multi-level feedback queue switches to a thread on a higher
+//	queue, or once the current thread's quantum is up, to one on the
+//	same queue.  Stride scheduling switches to a thread that is no
+//	further along than the current one.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::ShouldPreempt()
+{
+    if (schedulerType == RR || schedulerType == SJF)
+        return TRUE;
+    if (schedulerType == Priority)
+        return readyQueues->HighestPriority() <= 
+                kernel->currentThread->getPriority();
+    if (schedulerType == MLFQ) {
+        int level = LevelOf(kernel->currentThread);
+        int highest = readyQueues->HighestPriority();
+        return highest < level || (highest == level && quantumExpired);
+    }
+    if (schedulerType == Stride)
+        return !readyHeap->IsEmpty() && 
+                readyHeap->Front()->pass <= kernel->currentThread->pass;
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ShouldPreemptFor
+// 	Return whether "thread", just made ready, has less of its CPU
+//	burst left than the running thread does, so that preemptive SJF
+//	should switch to it right away, instead of waiting for the end
+//	of the time slice.  Not if the CPU is idle: then it will just
+//	be run.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::ShouldPreemptFor(Thread *thread)
+{
+    Thread *current = kernel->currentThread;
+
+    if (thread == current || current->getStatus() != RUNNING ||
+            kernel->interrupt->getStatus() == IdleMode)
+        return FALSE;
+    AccumNewBurst();            // bring the running thread's burst up to date
+    if (GetRestBurstTime(thread) >= GetRestBurstTime(current))
+        return FALSE;
+    DEBUG(dbgScheduling, "Thread " << thread->getName() << " preempts "
+            << current->getName());
+    return TRUE;
+}
+
+unsigned int
+Scheduler::NumReady()
+{
+    if (readyQueues != NULL)
+        return readyQueues->NumInQueues();
+    if (readyHeap != NULL)
+        return readyHeap->NumInHeap();
+    return readyList->NumInList();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::GetRestBurstTime
+// 	Return how much of its predicted CPU burst "thread" has left.
+//	Both are kept in the thread itself, so that comparing two
+//	threads on the ready heap costs no lookups.
+//----------------------------------------------------------------------
+
+Ticks
 Scheduler::GetRestBurstTime(Thread* thread)
 {
-    int estiBurst = (*burstTimeMap)[thread].first;
-    int accumBurst = (*burstTimeMap)[thread].second;
-    int restBurst = estiBurst - accumBurst;
+    Ticks restBurst = thread->burstEstimate - thread->burstUsed;
     return (restBurst < 0) ? 0 : restBurst;
 }
 
 void Scheduler::AccumNewBurst()
 {
     Thread* thread = kernel->currentThread;
-    (*burstTimeMap)[thread].second += (kernel->stats->userTicks - startTicks);
+    if (readyQueues != NULL) return; // no burst times to keep
+    thread->burstUsed += (kernel->stats->userTicks - startTicks);
     startTicks = kernel->stats->userTicks;
 }
 
+//----------------------------------------------------------------------
+// Scheduler::Account
+// 	The current thread's CPU burst is over: estimate the length of
+//	its next one, by exponential averaging.  If the thread is on the
+//	ready heap, it is moved to its new place there, in O(log n).
+//----------------------------------------------------------------------
+
 void Scheduler::Account()
 {
     Thread* sleepyThread = kernel->currentThread;
     
+    if (readyQueues != NULL) return; // no burst times to keep
     AccumNewBurst();
-    ASSERT(burstTimeMap->find(sleepyThread) != burstTimeMap->end());
-    int histBurst = (*burstTimeMap)[sleepyThread].first;
-    int newBurst = (*burstTimeMap)[sleepyThread].second;
-    int estiBurst = (int) (RATE * newBurst + (1-RATE) * histBurst);
-    (*burstTimeMap)[sleepyThread].first = estiBurst;
-    (*burstTimeMap)[sleepyThread].second = 0;
+    Ticks histBurst = sleepyThread->burstEstimate;
+    Ticks newBurst = sleepyThread->burstUsed;
+    Ticks estiBurst = (Ticks) (RATE * newBurst + (1-RATE) * histBurst);
+    sleepyThread->burstEstimate = estiBurst;
+    sleepyThread->burstUsed = 0;
+    if (readyHeap != NULL && sleepyThread->readyIndex >= 0)
+        readyHeap->Changed(sleepyThread->readyIndex);
     if (schedulerType == SJF || schedulerType == NSJF) {
         DEBUG(dbgScheduling, "Estimating the next CPU busrt time of thread " 
                 << sleepyThread->getName() << " ...");
@@ -290,3 +536,333 @@ void Scheduler::Account()
                 << ", estiBusrt: " << estiBurst);
     }
 }
+
+//----------------------------------------------------------------------
+// Scheduler::UseSlices
+// 	Called on a timer interrupt, when "slices" more time slices have
+//	gone by.  For the multi-level feedback queue, charge them to the
+//	current thread's quantum; once that is used up, the thread moves
+//	down a queue (see ShouldPreempt for the switch).  Every so often,
+//	boost every thread back to the top queue, so none starves.
+//
+//	For stride scheduling, charge the current thread for the CPU
+//	it has used, to see if it has got ahead of another.
+//----------------------------------------------------------------------
+
+void
+Scheduler::UseSlices(long long slices)
+{
+    Thread *thread = kernel->currentThread;
+    int level;
+
+    quantumExpired = FALSE;
+    if (schedulerType == Stride)
+        Charge();
+    if (schedulerType != MLFQ)
+        return;
+    if (kernel->stats->totalTicks - lastBoost >= boostPeriod * TimerTicks)
+        Boost();
+    if (kernel->interrupt->getStatus() == IdleMode)
+        return;                 // no one is running
+    
+    level = LevelOf(thread);
+    thread->quantumUsed += slices;
+    if (thread->quantumUsed >= quantum[level]) {
+        if (level < numLevels - 1)
+            thread->queueLevel = level + 1;
+        thread->quantumUsed = 0;
+        quantumExpired = TRUE;
+        DEBUG(dbgScheduling, "Thread " << thread->getName() 
+                << " used up its quantum, now on queue " << thread->queueLevel);
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::LevelOf
+// 	Return which queue of the multi-level feedback queue a thread
+//	belongs on.  A thread that hasn't been through the last boost
+//	(it was not running, or ready, but blocked) goes back to the top
+//	queue now, with a new quantum.
+//----------------------------------------------------------------------
+
+int
+Scheduler::LevelOf(Thread *thread)
+{
+    if (thread->boostsSeen != numBoosts) {
+        thread->boostsSeen = numBoosts;
+        thread->queueLevel = 0;
+        thread->quantumUsed = 0;
+    }
+    return thread->queueLevel;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Boost
+// 	Move every thread to the top queue of the multi-level feedback
+//	queue.  The ready threads are moved all at once, keeping their
+//	order; the rest find out from LevelOf.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Boost()
+{
+    DEBUG(dbgScheduling, "Boosting every thread to the top queue");
+    readyQueues->MergeToTop();
+    numBoosts++;
+    lastBoost = kernel->stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Switching
+// 	Keep track of a context switch for the multi-level feedback
+//	queue.  A thread that blocks before it has used up its quantum
+//	moves up a queue, with a new quantum; and the thread about to
+//	run has waited on its queue since it was made ready.
+//
+//	For stride scheduling, a thread that blocks (or finishes) stops
+//	competing for the CPU; and the pass of the thread about to run
+//	is where any thread that starts competing again starts from.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Switching(Thread *oldThread, Thread *nextThread, bool finishing)
+{
+    int level;
+    Ticks response;
+
+    if (schedulerType == Stride) {
+        Charge();
+        if (finishing || oldThread->getStatus() == BLOCKED)
+            StopCompeting(oldThread);
+        globalPass = nextThread->pass;
+        return;
+    }
+
+    if (!finishing && oldThread->getStatus() == BLOCKED) {
+        level = LevelOf(oldThread);
+        if (level > 0)
+            oldThread->queueLevel = level - 1;
+        oldThread->quantumUsed = 0;
+    }
+    
+    level = LevelOf(nextThread);
+    response = kernel->stats->totalTicks - nextThread->readySince;
+    numDispatched[level]++;
+    totalResponse[level] += response;
+    if (response > maxResponse[level])
+        maxResponse[level] = response;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::PrintResponseTimes
+// 	Print how long threads waited, from being made ready to
+//	running, on each queue of the multi-level feedback queue.
+//----------------------------------------------------------------------
+
+void
+Scheduler::PrintResponseTimes()
+{
+    for (int i = 0; i < numLevels; i++) {
+        cout << "MLFQ queue " << i << " (quantum " << quantum[i] 
+             << "): " << numDispatched[i] << " dispatches, response ";
+        if (numDispatched[i] > 0)
+            cout << "average " << totalResponse[i] / numDispatched[i]
+                 << ", max " << maxResponse[i] << " ticks\n";
+        else
+            cout << "none\n";
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Charge
+// 	Charge the running thread for the CPU it has used since the last
+//	time: its pass moves ahead, by less the more tickets it has.  Only
+//	busy time counts, and only while the thread is competing (the
+//	"main" thread, for one, isn't until it first gives up the CPU).
+//
+//	Meanwhile, each ticket of the competing threads was worth a share
+//	of that time; that is added up in "dueSoFar", from which each
+//	thread's due is worked out when it stops competing.  A thread can
+//	change its tickets while it runs (see Thread::setTickets); that
+//	takes effect here.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Charge()
+{
+    Ticks now = kernel->stats->totalTicks - kernel->stats->idleTicks;
+    Thread *thread = kernel->currentThread;
+    StrideShare *share = thread->share;
+    Ticks used = now - lastCharged;
+
+    lastCharged = now;
+    if (share == NULL || !share->competing)
+        return;
+    thread->pass += used * StrideOne / share->tickets;
+    share->ranTicks += used;
+    dueSoFar += (double) used / competingTickets;
+    if (thread->getTickets() != share->tickets) {
+        StopCompeting(thread);
+        StartCompeting(thread);
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::StartCompeting
+// 	"thread" is ready to run: from now on, its tickets count.  If it
+//	was blocked, it has fallen behind the others; it starts again
+//	from the pass of the last thread dispatched, so as not to have
+//	the CPU to itself until it catches up.
+//----------------------------------------------------------------------
+
+void
+Scheduler::StartCompeting(Thread *thread)
+{
+    StrideShare *share = thread->share;
+
+    if (share == NULL) {
+        share = thread->share = new StrideShare(thread);
+        shares->Append(share);
+    }
+    if (share->competing)
+        return;
+    share->competing = TRUE;
+    share->tickets = thread->getTickets();
+    share->dueSince = dueSoFar;
+    competingTickets += share->tickets;
+    if (thread->pass < globalPass)
+        thread->pass = globalPass;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::StopCompeting
+// 	"thread" has blocked, or finished: add up what its tickets were
+//	worth while it was competing, and stop counting them.
+//----------------------------------------------------------------------
+
+void
+Scheduler::StopCompeting(Thread *thread)
+{
+    StrideShare *share = thread->share;
+
+    if (share == NULL || !share->competing)
+        return;
+    share->dueTicks += share->tickets * (dueSoFar - share->dueSince);
+    share->competing = FALSE;
+    competingTickets -= share->tickets;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::PrintShares
+// 	Print what each thread got of the CPU under stride scheduling,
+//	against what its tickets entitled it to: a fair share of the time
+//	it was ready or running, among the others ready or running then.
+//----------------------------------------------------------------------
+
+void
+Scheduler::PrintShares()
+{
+    Charge();
+    ListIterator<StrideShare *> iter(shares);
+    for (; !iter.IsDone(); iter.Next()) {
+        StrideShare *share = iter.Item();
+        double due = share->dueTicks;
+
+        if (share->competing)   // count up to now
+            due += share->tickets * (dueSoFar - share->dueSince);
+        cout << "Stride share of " << share->name << " (" << share->tickets
+             << " tickets): ran " << share->ranTicks << " ticks, due "
+             << (Ticks) (due + 0.5) << " ticks";
+        if (due >= 1)
+            cout << ", " << (int) (100 * share->ranTicks / due + 0.5) << "%";
+        cout << "\n";
+    }
+}
+
+//----------------------------------------------------------------------
+// PriorityQueues::PriorityQueues
+// 	Initialize the ready queues of the priority scheduler: all empty.
+//----------------------------------------------------------------------
+
+PriorityQueues::PriorityQueues()
+{
+    nonEmpty = 0;
+    numInQueues = 0;
+}
+
+//----------------------------------------------------------------------
+// PriorityQueues::Append
+// 	Put a thread at the end of the queue for "level".
+//----------------------------------------------------------------------
+
+void
+PriorityQueues::Append(Thread *thread, int level)
+{
+    queue[level].Append(thread);
+    nonEmpty |= 1ULL << level;
+    numInQueues++;
+}
+
+//----------------------------------------------------------------------
+// PriorityQueues::RemoveFront
+// 	Take the first thread off the highest priority queue that has
+//	any, and return it; NULL if there are no threads.
+//----------------------------------------------------------------------
+
+Thread *
+PriorityQueues::RemoveFront()
+{
+    int level = HighestPriority();
+    Thread *thread;
+
+    if (level == NumPriorities)
+        return NULL;
+    thread = queue[level].RemoveFront();
+    if (queue[level].IsEmpty())
+        nonEmpty &= ~(1ULL << level);
+    numInQueues--;
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// PriorityQueues::HighestPriority
+// 	Return the highest priority (lowest level) that has any threads
+//	ready, by finding the first bit set in the bitmap; NumPriorities
+//	if none do.
+//----------------------------------------------------------------------
+
+int
+PriorityQueues::HighestPriority()
+{
+    if (nonEmpty == 0)
+        return NumPriorities;
+    return ffsll(nonEmpty) - 1;
+}
+
+//----------------------------------------------------------------------
+// PriorityQueues::Apply
+// 	Apply a function to each ready thread, in the order they will
+//	run: highest priority first, and first in first out within each.
+//----------------------------------------------------------------------
+
+void
+PriorityQueues::Apply(void (*f)(Thread *))
+{
+    for (int level = 0; level < NumPriorities; level++)
+        queue[level].Apply(f);
+}
+
+//----------------------------------------------------------------------
+// PriorityQueues::MergeToTop
+// 	Move every thread onto the level 0 queue, in the order they would
+//	have run: the queues are joined end to end, highest level first.
+//----------------------------------------------------------------------
+
+void
+PriorityQueues::MergeToTop()
+{
+    for (int level = 1; level < NumPriorities; level++)
+        queue[0].Concatenate(&queue[level]);
+    if (nonEmpty != 0)
+        nonEmpty = 1;
+}
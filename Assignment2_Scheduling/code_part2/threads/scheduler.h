@@ -12,15 +12,18 @@
 #include "copyright.h"
 #include "list.h"
 #include "thread.h"
-#include <map>
+#include "stats.h"
+#include "heap.h"
 
 class SleepingThread {
     public:
-        SleepingThread(Thread* t, int x)
-            : sleeper(t), sleepTime(x) {};
+        SleepingThread(Thread* t, Ticks when, unsigned long long n)
+            : sleeper(t), wakeTime(when), order(n) {};
         
         Thread* sleeper;
-        int sleepTime; // the remaining sleeping time
+        Ticks wakeTime; // when to wake up, in ticks since Nachos started
+        unsigned long long order; // which one went to sleep first, among
+                                  // those with the same wakeTime
 };
 
 // The following class defines the scheduler/dispatcher abstraction -- 
@@ -31,14 +34,85 @@ enum SchedulerType {
         FCFS,       // First Come First Served 
         RR,         // Round Robin
         NSJF,       // Shortest Job First (Non-preemptive)
-        SJF         // Shortest Job First (Preemptive)
+        SJF,        // Shortest Job First (Preemptive)
+        Priority,   // Priority levels, Round Robin within each
+        MLFQ,       // Multi-level feedback queue
+        Stride      // Stride scheduling: a share of the CPU for each,
+                    // in proportion to its tickets
 };
 
+// The default multi-level feedback queue: how many levels, the
+// quantum of the top level in time slices (each level below doubles
+// it), and how many time slices go by between priority boosts.
+const int DefaultMLFQLevels = 3;
+const int DefaultMLFQQuantum = 1;
+const int DefaultMLFQBoost = 100;
+
+// The ready threads of the priority scheduler (and of the multi-level
+// feedback queue): a FIFO queue for each priority level, linked through
+// the threads themselves (by Thread::queueLink), and a bitmap of the
+// levels that have any threads.  The first thread of the highest level is found with
+// find-first-set on the bitmap, so putting a thread on and taking
+// one off take the same time, however many threads are ready.
+
+class PriorityQueues {
+  public:
+    PriorityQueues();			// initially, no ready threads
+
+    void Append(Thread *thread, int level);
+					// put thread at the end of the
+					// queue for "level"
+    Thread *RemoveFront();		// take the first thread off the
+					// highest non-empty queue
+    int HighestPriority();		// the highest level with a thread
+					// on it; NumPriorities if none
+    void MergeToTop();			// move every thread to the level 0
+					// queue, highest level first
+
+    bool IsEmpty() { return nonEmpty == 0; }
+    unsigned int NumInQueues() { return numInQueues; }
+    void Apply(void (*f)(Thread *));	// apply function to the threads,
+					// in the order they will run
+
+  private:
+    ThreadQueue queue[NumPriorities];	// the queue of each level
+    unsigned long long nonEmpty;	// bit i is set if level i has
+					// any threads
+    unsigned int numInQueues;		// number of threads on the queues
+};
+
+// How much of the CPU a thread got under the stride scheduler, and how
+// much its tickets entitled it to, while it was ready or running.  Kept
+// by the scheduler until halt, when it is reported: the thread itself
+// may be gone by then.
+
+class StrideShare {
+  public:
+    StrideShare(Thread *t) : name(t->getName()), tickets(t->getTickets()),
+        ranTicks(0), dueTicks(0), dueSince(0), competing(FALSE) {};
+
+    char *name;                 // the thread's
+    int tickets;                // tickets counted for it, while competing
+    Ticks ranTicks;             // CPU time it got
+    double dueTicks;            // CPU time its tickets were worth
+    double dueSince;            // Scheduler::dueSoFar when it last started
+                                // competing, or was last accounted for
+    bool competing;             // is it ready or running?
+};
+
+// The pass of a thread goes up by StrideOne / tickets for each tick
+// it runs.
+const long long StrideOne = 1 << 20;
+
 const float RATE = 0.5;
 
 class Scheduler {
   public:
-	Scheduler(SchedulerType type);  // Initialize list of ready threads 
+	Scheduler(SchedulerType type, int levels = 0, int *quanta = NULL,
+		  int boost = 0);	// Initialize list of ready threads;
+					// for MLFQ, with "levels" queues, the
+					// quantum of each, and how often to
+					// boost priorities, in time slices
 	~Scheduler();				    // De-allocate ready list
 
 	void ReadyToRun(Thread* thread);	
@@ -50,17 +124,34 @@ class Scheduler {
 	void CheckToBeDestroyed();	// Check if thread that had been
     					// running needs to be deleted
 	void Print();			// Print contents of ready list
+	ThreadQueue *ReadyList() { return readyList; }
+					// The threads that are ready to run,
+					// in the order they will run; NULL
+					// unless FCFS or RR
     
     void SetToSleep(int sleepTime); 
-                    // insert the thread to the sleepingList
+                    // put the current thread to sleep for sleepTime
+                    // time slices
+    void SleepUntil(Ticks when);
+                    // put the current thread to sleep until time "when"
     void AlarmTicks();
-                    // minus sleepTime by 1 for each sleeping thread
-                    // if some thread should wake up now, do so
-    bool NoOneSleeping(); // return TRUE if sleepingList is empty
+                    // wake up the sleeping threads that are due by now
+    bool NoOneSleeping(); // return TRUE if sleepingHeap is empty
+    Ticks NextWakeup(); // when the first sleeping thread is due
+    long long TicksNeeded(); // whether the timer needs to go off at the end
+                             // of this time slice
+    bool ShouldPreempt(); // should the current thread give up the CPU at
+                          // the end of its time slice?
+    bool ShouldPreemptFor(Thread *thread); // should the current thread
+                          // give up the CPU to "thread", just made
+                          // ready, right away?
+    void UseSlices(long long slices); // the current thread has used up
+                          // "slices" more time slices
+    unsigned int NumReady(); // how many threads are ready to run
     
     SchedulerType GetSchedulerType() { return schedulerType; };
 
-    int GetRestBurstTime(Thread* thread);
+    Ticks GetRestBurstTime(Thread* thread);
     
     void AccumNewBurst(); // accumulate the new burst time
     
@@ -70,17 +161,60 @@ class Scheduler {
     
   private:
 	SchedulerType schedulerType;
-	List<Thread *> *readyList;	// queue of threads that are ready to run,
-					// but not running
+	ThreadQueue *readyList;	// queue of threads that are ready to run,
+					// but not running; for FCFS and RR,
+					// else NULL
+	Heap<Thread *> *readyHeap;	// the same, for NSJF and SJF, the
+					// shortest remaining burst first;
+					// for Stride, the lowest pass first
+	PriorityQueues *readyQueues;	// the same, for Priority and MLFQ;
+					// else NULL
 	Thread *toBeDestroyed;		// finishing thread to be destroyed
     					// by the next thread that runs
 
-    SortedList<SleepingThread *> *sleepingList;
+    Heap<SleepingThread *> *sleepingHeap;
+                    // sleeping threads, the first one due first
+    unsigned long long numSlept; // how many times a thread went to sleep
     
-    std::map<Thread *, std::pair<int, int> > *burstTimeMap;
-                        // record the CPU burst time of each thread
-                        // (*burstTimeMap)[thread]: (histBurst, newBurst)
-    int startTicks;
+    unsigned long long numReadied; // how many times a thread was put
+                                   // on the ready heap
+    Ticks startTicks;   // user ticks when the current burst was last
+                        // accounted for
+    
+    // for the multi-level feedback queue
+    int numLevels;              // how many queues there are
+    long long quantum[NumPriorities]; // the quantum of each, in time slices
+    long long boostPeriod;      // time slices between priority boosts
+    Ticks lastBoost;            // when the last boost was
+    int numBoosts;              // how many boosts there have been
+    bool quantumExpired;        // did the current thread just use up
+                                // its quantum?
+    long long numDispatched[NumPriorities]; // threads run from each queue
+    Ticks totalResponse[NumPriorities]; // and how long they waited to,
+    Ticks maxResponse[NumPriorities];   // in total and at most
+
+    // for stride scheduling
+    List<StrideShare *> *shares; // of every thread that has been ready
+    int competingTickets;       // tickets of the threads ready or running
+    double dueSoFar;            // CPU time each ticket has been worth,
+                                // in total
+    Ticks lastCharged;          // busy ticks when the running thread
+                                // was last charged for the CPU
+    long long globalPass;       // pass of the thread dispatched last
+
+    void Charge();              // charge the running thread for the CPU
+                                // it has used since the last time
+    void StartCompeting(Thread *thread); // it is ready: count it in
+    void StopCompeting(Thread *thread);  // it is blocked, or finished
+    void PrintShares();         // print what each got of the CPU
+
+    int LevelOf(Thread *thread); // the queue thread belongs on
+    void Boost();               // move every thread to the top queue
+    void Switching(Thread *oldThread, Thread *nextThread, bool finishing);
+                                // keep track of a context switch, for
+                                // MLFQ and Stride
+    void PrintResponseTimes();  // print how long threads waited on
+                                // each queue
 };
 
 #endif // SCHEDULER_H
@@ -40,6 +40,12 @@ class SynchDisk : public CallBackObj {
 					// then wait until the request is done.
     void WriteSector(int sectorNumber, char* data, bool loadTime = FALSE);
     
+    void WriteSnapshot(int fd) { disk->WriteSnapshot(fd); }
+    void ReadSnapshot(int fd) { disk->ReadSnapshot(fd); }
+					// Save/restore the disk's contents
+					// to/from the UNIX file "fd"; no
+					// request can be in progress
+
     void CallBack();			// Called by the disk device interrupt
 					// handler, to signal that the
 					// current disk operation is complete.
@@ -84,4 +84,17 @@ extern Debug *debug;
         Abort();                                                              \
     }
 
+//----------------------------------------------------------------------
+// PARANOID_ASSERT
+//      Like ASSERT, but only checked in a paranoid build (compiled
+//	with -DPARANOID).  For checks too slow to make on every call,
+//	such as walking a whole list to see whether an item is on it.
+//----------------------------------------------------------------------
+
+#ifdef PARANOID
+#define PARANOID_ASSERT(condition) ASSERT(condition)
+#else
+#define PARANOID_ASSERT(condition)
+#endif
+
 #endif //DEBUG_H
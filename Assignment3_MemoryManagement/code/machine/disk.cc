@@ -60,17 +60,19 @@ Disk::Disk(char* name, CallBackObj *toCall)
         Lseek(fileno, DiskSize - sizeof(int), 0);	
 	WriteFile(fileno, (char *)&tmp, sizeof(int));  
     }
-    active = FALSE;
+    request = NULL;
 }
 
 //----------------------------------------------------------------------
 // Disk::~Disk()
-// 	Clean up disk simulation, by closing the UNIX file representing the
-//	disk.
+// 	Clean up disk simulation, by calling off the request in progress,
+//	if any, and closing the UNIX file representing the disk.
 //----------------------------------------------------------------------
 
 Disk::~Disk()
 {
+    if (request != NULL)
+	request->Cancel();
     Close(fileno);
 }
 
@@ -114,7 +116,7 @@ Disk::ReadRequest(int sectorNumber, char* data, bool loadTime)
 {
     int ticks = ComputeLatency(sectorNumber, FALSE);
 
-    if (!loadTime) ASSERT(!active);				// only one request at a time
+    if (!loadTime) ASSERT(request == NULL);	// only one request at a time
     ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
     
     DEBUG(dbgDisk, "Reading from sector " << sectorNumber);
@@ -123,10 +125,9 @@ Disk::ReadRequest(int sectorNumber, char* data, bool loadTime)
     if (debug->IsEnabled('d'))
 	PrintSector(FALSE, sectorNumber, data);
     
-    if (!loadTime) active = TRUE;
     UpdateLast(sectorNumber);
     kernel->stats->numDiskReads++;
-    if (!loadTime) kernel->interrupt->Schedule(this, ticks, DiskInt);
+    if (!loadTime) request = kernel->interrupt->Schedule(this, ticks, DiskInt);
 }
 
 void
@@ -134,7 +135,7 @@ Disk::WriteRequest(int sectorNumber, char* data, bool loadTime)
 {
     int ticks = ComputeLatency(sectorNumber, TRUE);
 
-    if (!loadTime) ASSERT(!active);
+    if (!loadTime) ASSERT(request == NULL);
     ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
     
     DEBUG(dbgDisk, "Writing to sector " << sectorNumber);
@@ -143,10 +144,9 @@ Disk::WriteRequest(int sectorNumber, char* data, bool loadTime)
     if (debug->IsEnabled('d'))
 	PrintSector(TRUE, sectorNumber, data);
     
-    if (!loadTime) active = TRUE;
     UpdateLast(sectorNumber);
     kernel->stats->numDiskWrites++;
-    if (!loadTime) kernel->interrupt->Schedule(this, ticks, DiskInt);
+    if (!loadTime) request = kernel->interrupt->Schedule(this, ticks, DiskInt);
 }
 
 //----------------------------------------------------------------------
@@ -157,7 +157,7 @@ Disk::WriteRequest(int sectorNumber, char* data, bool loadTime)
 void
 Disk::CallBack ()
 { 
-    active = FALSE;
+    request = NULL;
     callWhenDone->CallBack();
 }
 
@@ -179,7 +179,7 @@ Disk::TimeToSeek(int newSector, int *rotation)
     int oldTrack = lastSector / SectorsPerTrack;
     int seek = abs(newTrack - oldTrack) * SeekTime;
 				// how long will seek take?
-    int over = (kernel->stats->totalTicks + seek) % RotationTime; 
+    int over = (int) ((kernel->stats->totalTicks + seek) % RotationTime); 
 				// will we be in the middle of a sector when
 				// we finish the seek?
 
@@ -196,10 +196,10 @@ Disk::TimeToSeek(int newSector, int *rotation)
 //----------------------------------------------------------------------
 
 int 
-Disk::ModuloDiff(int to, int from)
+Disk::ModuloDiff(int to, Ticks from)
 {
     int toOffset = to % SectorsPerTrack;
-    int fromOffset = from % SectorsPerTrack;
+    int fromOffset = (int) (from % SectorsPerTrack);
 
     return ((toOffset - fromOffset) + SectorsPerTrack) % SectorsPerTrack;
 }
@@ -230,7 +230,7 @@ Disk::ComputeLatency(int newSector, bool writing)
 {
     int rotation;
     int seek = TimeToSeek(newSector, &rotation);
-    int timeAfter = kernel->stats->totalTicks + seek + rotation;
+    Ticks timeAfter = kernel->stats->totalTicks + seek + rotation;
 
 #ifndef NOTRACKBUF	// turn this on if you don't want the track buffer stuff
     // check if track buffer applies
@@ -265,3 +265,43 @@ Disk::UpdateLast(int newSector)
     lastSector = newSector;
     DEBUG(dbgDisk, "Updating last sector = " << lastSector << " , " << bufferInit);
 }
+
+//----------------------------------------------------------------------
+// Disk::WriteSnapshot
+//   	Write the contents of the whole disk to the UNIX file "fd", with
+//	what we know about the track buffer, so that ReadSnapshot can put
+//	the disk back as it is now.  No request can be in progress.
+//----------------------------------------------------------------------
+
+void
+Disk::WriteSnapshot(int fd)
+{
+    char *buffer = new char[NumSectors * SectorSize];
+
+    ASSERT(request == NULL);
+    Lseek(fileno, MagicSize, 0);
+    Read(fileno, buffer, NumSectors * SectorSize);
+    WriteFile(fd, buffer, NumSectors * SectorSize);
+    WriteFile(fd, (char *) &lastSector, sizeof(int));
+    WriteFile(fd, (char *) &bufferInit, sizeof(Ticks));
+    delete [] buffer;
+}
+
+//----------------------------------------------------------------------
+// Disk::ReadSnapshot
+//   	Read back what WriteSnapshot wrote into the UNIX file "fd".
+//----------------------------------------------------------------------
+
+void
+Disk::ReadSnapshot(int fd)
+{
+    char *buffer = new char[NumSectors * SectorSize];
+
+    ASSERT(request == NULL);
+    Read(fd, buffer, NumSectors * SectorSize);
+    Lseek(fileno, MagicSize, 0);
+    WriteFile(fileno, buffer, NumSectors * SectorSize);
+    Read(fd, (char *) &lastSector, sizeof(int));
+    Read(fd, (char *) &bufferInit, sizeof(Ticks));
+    delete [] buffer;
+}
@@ -31,43 +31,7 @@
 
 #include "copyright.h"
 #include "main.h"
-
-// Routines for converting Words and Short Words to and from the
-// simulated machine's format of little endian.  These end up
-// being NOPs when the host machine is also little endian (DEC and Intel).
-
-unsigned int
-WordToHost(unsigned int word) {
-#ifdef HOST_IS_BIG_ENDIAN
-	 register unsigned long result;
-	 result = (word >> 24) & 0x000000ff;
-	 result |= (word >> 8) & 0x0000ff00;
-	 result |= (word << 8) & 0x00ff0000;
-	 result |= (word << 24) & 0xff000000;
-	 return result;
-#else 
-	 return word;
-#endif /* HOST_IS_BIG_ENDIAN */
-}
-
-unsigned short
-ShortToHost(unsigned short shortword) {
-#ifdef HOST_IS_BIG_ENDIAN
-	 register unsigned short result;
-	 result = (shortword << 8) & 0xff00;
-	 result |= (shortword >> 8) & 0x00ff;
-	 return result;
-#else 
-	 return shortword;
-#endif /* HOST_IS_BIG_ENDIAN */
-}
-
-unsigned int
-WordToMachine(unsigned int word) { return WordToHost(word); }
-
-unsigned short
-ShortToMachine(unsigned short shortword) { return ShortToHost(shortword); }
-
+#include "jit.h"
 
 //----------------------------------------------------------------------
 // Machine::ReadMem
@@ -145,6 +109,9 @@ Machine::WriteMem(int addr, int size, int value)
 	RaiseException(exception, addr);
 	return FALSE;
     }
+    decodeValid[physicalAddress / 4] = FALSE;	// in case it is code
+    if (translator != NULL && translator->IsTranslated(physicalAddress))
+	translator->InvalidatePage(physicalAddress / PageSize);
     switch (size) {
       case 1:
 	mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
@@ -188,6 +155,7 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     unsigned int vpn, offset;
     TranslationEntry *entry;
     unsigned int pageFrame;
+    TransCacheEntry *cached;
 
     DEBUG(dbgAddr, "\tTranslate " << virtAddr << (writing ? " , write" : " , read"));
 
@@ -196,15 +164,28 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	DEBUG(dbgAddr, "Alignment problem at " << virtAddr << ", size " << size);
 	return AddressErrorException;
     }
-    
-    // we must have either a TLB or a page table, but not both!
-    ASSERT(tlb == NULL || pageTable == NULL);	
-    ASSERT(tlb != NULL || pageTable != NULL);	
 
 // calculate the virtual page number, and offset within the page,
 // from the virtual address
     vpn = (unsigned) virtAddr / PageSize;
     offset = (unsigned) virtAddr % PageSize;
+
+// the common case: the page was translated recently.  Its use bit (and
+// dirty bit, if the entry is writable) was set then.
+    cached = &transCache[vpn % TransCacheSize];
+    if (cached->readable && cached->virtualPage == vpn
+		&& (cached->writable || !writing)) {
+	pageFrame = (cached->page - mainMemory) / PageSize;
+	kernel->memoryManager->UpdateLRUStack(pageFrame);
+	kernel->memoryManager->CheckLock(pageFrame);
+	*physAddr = (cached->page - mainMemory) + offset;
+	DEBUG(dbgAddr, "phys addr = " << *physAddr);
+	return NoException;
+    }
+    
+    // we must have either a TLB or a page table, but not both!
+    ASSERT(tlb == NULL || pageTable == NULL);	
+    ASSERT(tlb != NULL || pageTable != NULL);	
     
     if (tlb == NULL) {		// => page table => vpn is index into table
 	if (vpn >= pageTableSize) {
@@ -248,7 +229,28 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     if (writing)
 	entry->dirty = TRUE;
     *physAddr = pageFrame * PageSize + offset;
-    ASSERT((*physAddr >= 0) && ((*physAddr + size) <= MemorySize));
+    ASSERT((*physAddr >= 0) && ((*physAddr + size) <= MemorySize()));
+
+    cached->readable = TRUE;	// remember it for next time
+    cached->writable = entry->dirty && !entry->readOnly;
+    cached->virtualPage = vpn;
+    cached->page = mainMemory + pageFrame * PageSize;
+
     DEBUG(dbgAddr, "phys addr = " << *physAddr);
     return NoException;
 }
+
+//----------------------------------------------------------------------
+// Machine::FlushTransCache
+// 	Empty the translation cache, so that the next access to every
+//	page goes through the page table (or TLB) again.
+//----------------------------------------------------------------------
+
+void
+Machine::FlushTransCache()
+{
+    for (int i = 0; i < TransCacheSize; i++) {
+	transCache[i].readable = FALSE;
+	transCache[i].writable = FALSE;
+    }
+}
@@ -25,7 +25,10 @@
 ThreadedKernel::ThreadedKernel(int argc, char **argv)
 {
     randomSlice = FALSE;
+    tickless = FALSE;
     schedulerType = RR; // default scheduling: round-robin
+    mlfqLevels = 0;     // default queues
+    mlfqBoost = 0;
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-rs") == 0) {
             ASSERT(i + 1 < argc);
@@ -38,12 +41,41 @@ ThreadedKernel::ThreadedKernel(int argc, char **argv)
         else if (strcmp(argv[i], "-RR") == 0) schedulerType = RR;
         else if (strcmp(argv[i], "-NSJF") == 0) schedulerType = NSJF;
         else if (strcmp(argv[i], "-SJF") == 0) schedulerType = SJF;
+        else if (strcmp(argv[i], "-PRIORITY") == 0) schedulerType = Priority;
+        else if (strcmp(argv[i], "-MLFQ") == 0) schedulerType = MLFQ;
+        else if (strcmp(argv[i], "-STRIDE") == 0) schedulerType = Stride;
+        else if (strcmp(argv[i], "-quanta") == 0) {
+            ASSERT(i + 1 < argc);
+            char *quanta = argv[++i];   // comma separated, top queue first
+            mlfqLevels = 0;
+            while (*quanta != '\0') {
+                ASSERT(mlfqLevels < NumPriorities);
+                mlfqQuanta[mlfqLevels++] = strtol(quanta, &quanta, 10);
+                if (*quanta == ',') quanta++;
+            }
+        }
+        else if (strcmp(argv[i], "-boost") == 0) {
+            ASSERT(i + 1 < argc);
+            mlfqBoost = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-tickless") == 0) tickless = TRUE;
+        else if (strcmp(argv[i], "-pool") == 0) {
+            ASSERT(i + 1 < argc);
+            Thread::SetPoolLimit(atoi(argv[++i]));
+        }
         else if (strcmp(argv[i], "-u") == 0) {
             cout << "Partial usage: nachos [-rs randomSeed]\n";
+            cout << "Partial usage: nachos [-tickless]\n";
+            cout << "Partial usage: nachos [-pool threads] (finished threads to keep)\n";
             cout << "Partial usage: nachos [-FCFS FCFS Scheduling]\n";
             cout << "                      [-RR RR Scheduling]\n";
             cout << "                      [-NSJF Non-preemptive SJF Scheduling]\n";
             cout << "                      [-SJF Preemptive SJF Scheduling]\n";
+            cout << "                      [-PRIORITY Priority Scheduling]\n";
+            cout << "                      [-MLFQ Multi-level Feedback Queue Scheduling]\n";
+            cout << "                      [-STRIDE Stride Scheduling]\n";
+            cout << "Partial usage: nachos [-quanta slices,slices,...] (-MLFQ queues)\n";
+            cout << "Partial usage: nachos [-boost slices] (-MLFQ priority boosts)\n";
 	    }
     }
 }
@@ -60,8 +92,9 @@ ThreadedKernel::Initialize()
 {
     stats = new Statistics();                   // collect statistics
     interrupt = new Interrupt;		            // start up interrupt handling
-    scheduler = new Scheduler(schedulerType);	// initialize the ready queue
-    alarm = new Alarm(randomSlice);             // start up time slicing
+    scheduler = new Scheduler(schedulerType,    // initialize the ready queue
+                        mlfqLevels, mlfqQuanta, mlfqBoost);
+    alarm = new Alarm(randomSlice, tickless);   // start up time slicing
 
     // usedPhysPages[NumPhysPages] = {FALSE};
 
@@ -270,15 +270,164 @@ void AddrSpace::RestoreState()
 {
     kernel->machine->pageTable = pageTable;
     kernel->machine->pageTableSize = numPages;
+    kernel->machine->FlushTransCache();
 }
 
 void AddrSpace::SetInvalid(unsigned int vpn)
 {
     pageTable[vpn].valid = FALSE;
+    kernel->machine->FlushTransCache();
 }
 
 void AddrSpace::UpdatePhysPage(unsigned int vpn, unsigned int newPage)
 {
     pageTable[vpn].valid = TRUE;
     pageTable[vpn].physicalPage = newPage;
+    kernel->machine->FlushTransCache();
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::WriteSnapshot
+// 	Write the size of the address space and its page table to the
+//	UNIX file "fd".  The pages themselves are saved with the rest
+//	of physical memory and the swap disk.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::WriteSnapshot(int fd)
+{
+    WriteFile(fd, (char *) &numPages, sizeof(unsigned int));
+    WriteFile(fd, (char *) pageTable, numPages * sizeof(TranslationEntry));
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ReadSnapshot
+// 	Set up an address space that was saved by WriteSnapshot, in
+//	place of loading a program into it.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::ReadSnapshot(int fd)
+{
+    Read(fd, (char *) &numPages, sizeof(unsigned int));
+    pageTable = new TranslationEntry[numPages];
+    Read(fd, (char *) pageTable, numPages * sizeof(TranslationEntry));
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyIn
+// 	Copy "size" bytes of user memory, starting at "virtAddr", into
+//	the kernel's "buffer".  The copy is done a page at a time, so
+//	each page is only looked up once.  Return FALSE if some of the
+//	bytes are not in the address space.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::CopyIn(int virtAddr, char *buffer, int size)
+{
+    char *page;
+    int offset, n;
+
+    for (; size > 0; virtAddr += n, buffer += n, size -= n) {
+	offset = (unsigned) virtAddr % PageSize;
+	n = min(size, (int) PageSize - offset);
+	page = UserPage((unsigned) virtAddr / PageSize, FALSE);
+	if (page == NULL)
+	    return FALSE;
+	bcopy(page + offset, buffer, n);
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyOut
+// 	Copy "size" bytes from the kernel's "buffer" into user memory,
+//	starting at "virtAddr", a page at a time.  Return FALSE if some
+//	of the bytes are not in the address space, or are read-only.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::CopyOut(char *buffer, int virtAddr, int size)
+{
+    char *page;
+    int offset, n;
+
+    for (; size > 0; virtAddr += n, buffer += n, size -= n) {
+	offset = (unsigned) virtAddr % PageSize;
+	n = min(size, (int) PageSize - offset);
+	page = UserPage((unsigned) virtAddr / PageSize, TRUE);
+	if (page == NULL)
+	    return FALSE;
+	bcopy(buffer, page + offset, n);
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyInString
+// 	Copy a null-terminated string from user memory, starting at
+//	"virtAddr", into the kernel's "buffer", which has room for
+//	"maxLength" bytes (including the null).  Return the length of
+//	the string, or -1 if it is not in the address space or doesn't
+//	fit in the buffer.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::CopyInString(int virtAddr, char *buffer, int maxLength)
+{
+    char *page, *end;
+    int offset, n;
+    int length = 0;
+
+    while (length < maxLength) {
+	offset = (unsigned) virtAddr % PageSize;
+	n = min(maxLength - length, (int) PageSize - offset);
+	page = UserPage((unsigned) virtAddr / PageSize, FALSE);
+	if (page == NULL)
+	    return -1;
+	end = (char *) memchr(page + offset, '\0', n);
+	if (end != NULL) {			// found the end of the string
+	    n = end - (page + offset);
+	    bcopy(page + offset, buffer + length, n + 1);
+	    return length + n;
+	}
+	bcopy(page + offset, buffer + length, n);
+	length += n;
+	virtAddr += n;
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::UserPage
+// 	Return where virtual page "vpn" of this address space starts in
+//	"mainMemory", so the kernel can copy to or from it, setting
+//	the use and dirty bits as the hardware would.  A page that has
+//	been swapped out is brought back in first.  Return NULL if the
+//	page can't be read (or, if "writing", written).
+//----------------------------------------------------------------------
+
+char *
+AddrSpace::UserPage(unsigned int vpn, bool writing)
+{
+    TranslationEntry *entry;
+
+    if (vpn >= numPages)
+	return NULL;
+    entry = &pageTable[vpn];
+    if (writing && entry->readOnly)
+	return NULL;
+    if (!entry->valid) {		// in the swap disk
+	ASSERT(this == kernel->currentThread->space);
+	kernel->stats->numPageFaults++;
+	kernel->memoryManager->PageFaultHandler(vpn);
+    }
+    kernel->memoryManager->UpdateLRUStack(entry->physicalPage);
+    kernel->memoryManager->CheckLock(entry->physicalPage);
+    entry->use = TRUE;
+    if (writing) {
+	entry->dirty = TRUE;
+	kernel->machine->InvalidateDecodedPage(entry->physicalPage);
+    }
+    return kernel->machine->mainMemory + entry->physicalPage * PageSize;
 }
@@ -34,6 +34,22 @@ class AddrSpace {
     void UpdatePhysPage(unsigned int vpn, unsigned int newPage);  
                     // update physical page and set the page to valid
 
+    void WriteSnapshot(int fd);		// Save the page table to the
+					// UNIX file "fd"
+    void ReadSnapshot(int fd);		// Read it back, for a program
+					// resumed from a snapshot
+
+    bool CopyIn(int virtAddr, char *buffer, int size);
+    bool CopyOut(char *buffer, int virtAddr, int size);
+					// Copy "size" bytes between user
+					// memory and a kernel buffer; return
+					// FALSE if some of it is not legal
+    int CopyInString(int virtAddr, char *buffer, int maxLength);
+					// Copy a null-terminated string from
+					// user memory into "buffer", which
+					// holds "maxLength" bytes; return its
+					// length, or -1 if it doesn't fit
+
   private:
     TranslationEntry *pageTable;	// Assume linear page table translation
 					// for now!
@@ -46,6 +62,11 @@ class AddrSpace {
     void InitRegisters();		// Initialize user-level CPU registers,
 					// before jumping to user code
 
+    char *UserPage(unsigned int vpn, bool writing);
+					// Where virtual page "vpn" is in
+					// "mainMemory", or NULL if it can't
+					// be read (or written)
+
 };
 
 #endif // ADDRSPACE_H
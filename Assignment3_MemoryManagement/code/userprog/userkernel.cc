@@ -13,29 +13,32 @@
 
 MemoryManager::MemoryManager()
 {
+    ASSERT(PageSize % SectorSize == 0);     // pages go to whole sectors
+    sectorsPerPage = PageSize / SectorSize;
+    numSwapPages = NumSectors / sectorsPerPage;
     frameTable = new FrameInfoEntry[NumPhysPages];
     for (unsigned int i = 0; i < NumPhysPages; i++) {
         frameTable[i].valid = TRUE;
         frameTable[i].lock = FALSE;
         frameTable[i].addrSpace = 0;
         frameTable[i].vpn = 0;
+        frameTable[i].lastUsed = 0;
     }
-    swapTable = new FrameInfoEntry[NumSectors];
-    for (unsigned int i = 0; i < NumSectors; i++) {
+    swapTable = new FrameInfoEntry[numSwapPages];
+    for (unsigned int i = 0; i < numSwapPages; i++) {
         swapTable[i].valid = TRUE;
         swapTable[i].lock = FALSE;
         swapTable[i].addrSpace = 0;
         swapTable[i].vpn = 0;
+        swapTable[i].lastUsed = 0;
     }
-    LRUstack = new List<unsigned int>;
+    useClock = 0;
 }
 
 MemoryManager::~MemoryManager()
 {
     delete[] frameTable;
     delete[] swapTable;
-    while (!LRUstack->IsEmpty()) LRUstack->RemoveFront();
-    delete LRUstack;
 }
 
 int
@@ -64,7 +67,8 @@ MemoryManager::AcquirePage(AddrSpace *space, unsigned int vpn, bool loadTime)
             frameTable[i].addrSpace = space;
             frameTable[i].vpn = vpn;
             newPage = i;
-            LRUstack->Append(newPage);
+            UpdateLRUStack(newPage);
+            kernel->machine->InvalidateDecodedPage(newPage);
             DEBUG(dbgSwap, "Acquring frame page " << newPage);
             return newPage;
         }
@@ -75,7 +79,9 @@ MemoryManager::AcquirePage(AddrSpace *space, unsigned int vpn, bool loadTime)
     ASSERT(!(frameTable[newPage].valid));
     frameTable[newPage].addrSpace = space;
     frameTable[newPage].vpn = vpn;
-    LRUstack->Append(newPage);
+    UpdateLRUStack(newPage);
+    kernel->machine->InvalidateDecodedPage(newPage);
+                                // the frame is getting new contents
     DEBUG(dbgSwap, "Acquring frame page " << newPage);
     return newPage;
 }
@@ -86,9 +92,8 @@ MemoryManager::ReleasePage(AddrSpace *space, unsigned int vpn)
     for (unsigned int i = 0; i < NumPhysPages; i++)
         if (frameTable[i].addrSpace == space && frameTable[i].vpn == vpn) {
             frameTable[i].valid = TRUE;
-            LRUstack->Remove(i);
         }
-    for (unsigned int i = 0; i < NumSectors; i++)
+    for (unsigned int i = 0; i < numSwapPages; i++)
         if (swapTable[i].addrSpace == space && swapTable[i].vpn == vpn) {
             swapTable[i].valid = TRUE;
         }
@@ -99,14 +104,14 @@ MemoryManager::PageFaultHandler(unsigned int vpn, bool loadTime)
 {
     AddrSpace* space = kernel->currentThread->space;
     
-    unsigned int swapBackPage = NumSectors;
-    for (unsigned int i = 0; i < NumSectors; i++)
+    unsigned int swapBackPage = numSwapPages;
+    for (unsigned int i = 0; i < numSwapPages; i++)
         if (!swapTable[i].valid &&
             swapTable[i].addrSpace == space && swapTable[i].vpn == vpn) {
             swapBackPage = i;
             break;
         }
-    ASSERT(swapBackPage != NumSectors);     // the page must in swap disk
+    ASSERT(swapBackPage != numSwapPages);     // the page must in swap disk
     while (swapTable[swapBackPage].lock) kernel->currentThread->Yield();
     
     unsigned int newPage = AcquirePage(space, vpn, loadTime);
@@ -117,7 +122,7 @@ MemoryManager::PageFaultHandler(unsigned int vpn, bool loadTime)
     ASSERT(!(swapTable[swapBackPage].lock));
     frameTable[newPage].lock = TRUE;
     swapTable[swapBackPage].lock = TRUE;
-    kernel->swapDisk->ReadSector(swapBackPage, newPos, loadTime);
+    ReadSwap(swapBackPage, newPos, loadTime);
                                 // return only after the data has been read
     frameTable[newPage].lock = FALSE;
     swapTable[swapBackPage].lock = FALSE;
@@ -132,8 +137,7 @@ MemoryManager::PageFaultHandler(unsigned int vpn, bool loadTime)
 void 
 MemoryManager::UpdateLRUStack(unsigned int recentlyUsedPage)
 {
-    LRUstack->Remove(recentlyUsedPage);
-    LRUstack->Append(recentlyUsedPage);
+    frameTable[recentlyUsedPage].lastUsed = ++useClock;
 }
 
 void 
@@ -146,15 +150,13 @@ MemoryManager::CheckLock(unsigned int page)
 unsigned int
 MemoryManager::KickVictim(bool loadTime)
 {
-    unsigned int victimPage;
-    ListIterator<unsigned int> iter(LRUstack);
-    for (; !iter.IsDone(); iter.Next()) {
-        if (!(frameTable[iter.Item()].lock)) {
-            LRUstack->Remove(iter.Item());
-            victimPage = iter.Item();
-            break;
-        }
-    }
+    unsigned int victimPage = NumPhysPages;
+    for (unsigned int i = 0; i < NumPhysPages; i++) // least recently used
+        if (!(frameTable[i].valid) && !(frameTable[i].lock) &&
+            (victimPage == NumPhysPages ||
+             frameTable[i].lastUsed < frameTable[victimPage].lastUsed))
+            victimPage = i;
+    ASSERT(victimPage != NumPhysPages);       // some frame is not doing I/O
     ASSERT(!(frameTable[victimPage].lock));   // not doing I/O
     ASSERT(!(frameTable[victimPage].valid));  // keep FALSE
     
@@ -163,8 +165,10 @@ MemoryManager::KickVictim(bool loadTime)
     char* victimData = kernel->machine->mainMemory + victimPage * PageSize;
     
     victimSpace->SetInvalid(victimVPN); // set the page table
+    kernel->machine->InvalidateDecodedPage(victimPage);
+                                // its code is leaving this frame
     
-    for (unsigned int i = 0; i < NumSectors; i++) { // find valid swap sector
+    for (unsigned int i = 0; i < numSwapPages; i++) { // find valid swap slot
         if (swapTable[i].valid && !(swapTable[i].lock)) {
             swapTable[i].valid = FALSE;
             swapTable[i].addrSpace = victimSpace;
@@ -175,7 +179,7 @@ MemoryManager::KickVictim(bool loadTime)
             ASSERT(!(swapTable[i].lock));
             frameTable[victimPage].lock = TRUE;
             swapTable[i].lock = TRUE;
-            kernel->swapDisk->WriteSector(i, victimData, loadTime);
+            WriteSwap(i, victimData, loadTime);
                                 // return only after the data has been written
             frameTable[victimPage].lock = FALSE;
             swapTable[i].lock = FALSE;
@@ -187,6 +191,264 @@ MemoryManager::KickVictim(bool loadTime)
     return 0;
 }
 
+//----------------------------------------------------------------------
+// MemoryManager::ReadSwap
+// MemoryManager::WriteSwap
+// 	Move a page between "data" and its slot in the swap disk: the
+//	slot's sectors, one after another.  Return only when it is done.
+//----------------------------------------------------------------------
+
+void
+MemoryManager::ReadSwap(unsigned int slot, char *data, bool loadTime)
+{
+    for (unsigned int i = 0; i < sectorsPerPage; i++)
+        kernel->swapDisk->ReadSector(slot * sectorsPerPage + i,
+                                     data + i * SectorSize, loadTime);
+}
+
+void
+MemoryManager::WriteSwap(unsigned int slot, char *data, bool loadTime)
+{
+    for (unsigned int i = 0; i < sectorsPerPage; i++)
+        kernel->swapDisk->WriteSector(slot * sectorsPerPage + i,
+                                      data + i * SectorSize, loadTime);
+}
+
+// Snapshot files are a series of ints, and 64-bit times and counts,
+// with byte arrays in between.
+
+const int SnapshotMagic = 0x5a5a1998;
+
+static void
+WriteInt(int fd, int value)
+{
+    WriteFile(fd, (char *) &value, sizeof(int));
+}
+
+static int
+ReadInt(int fd)
+{
+    int value;
+
+    Read(fd, (char *) &value, sizeof(int));
+    return value;
+}
+
+static void
+WriteLong(int fd, long long value)
+{
+    WriteFile(fd, (char *) &value, sizeof(long long));
+}
+
+static long long
+ReadLong(int fd)
+{
+    long long value;
+
+    Read(fd, (char *) &value, sizeof(long long));
+    return value;
+}
+
+// Where "space" is in "spaces", or -1 if it isn't.
+
+static int
+SpaceIndex(List<AddrSpace *> *spaces, AddrSpace *space)
+{
+    ListIterator<AddrSpace *> iter(spaces);
+    int i = 0;
+
+    for (; !iter.IsDone(); iter.Next(), i++)
+        if (iter.Item() == space)
+            return i;
+    return -1;
+}
+
+// Save/restore "n" entries of a frame or swap table.  Free entries
+// may still point to an address space that has been deleted, so the
+// space is only saved for the entries in use.
+
+static void
+WriteTable(int fd, FrameInfoEntry *table, int n, List<AddrSpace *> *spaces)
+{
+    for (int i = 0; i < n; i++) {
+        WriteInt(fd, table[i].valid);
+        WriteInt(fd, table[i].lock);
+        WriteInt(fd, table[i].valid ? -1 : SpaceIndex(spaces, table[i].addrSpace));
+        WriteInt(fd, table[i].vpn);
+        WriteLong(fd, table[i].lastUsed);
+    }
+}
+
+static void
+ReadTable(int fd, FrameInfoEntry *table, int n, AddrSpace **spaces)
+{
+    int spaceIndex;
+
+    for (int i = 0; i < n; i++) {
+        table[i].valid = ReadInt(fd);
+        table[i].lock = ReadInt(fd);
+        spaceIndex = ReadInt(fd);
+        table[i].addrSpace = (spaceIndex < 0) ? NULL : spaces[spaceIndex];
+        table[i].vpn = ReadInt(fd);
+        table[i].lastUsed = ReadLong(fd);
+    }
+}
+
+void
+MemoryManager::ListSpaces(List<AddrSpace *> *spaces)
+{
+    for (unsigned int i = 0; i < NumPhysPages; i++)
+        if (!frameTable[i].valid && !spaces->IsInList(frameTable[i].addrSpace))
+            spaces->Append(frameTable[i].addrSpace);
+    for (unsigned int i = 0; i < numSwapPages; i++)
+        if (!swapTable[i].valid && !spaces->IsInList(swapTable[i].addrSpace))
+            spaces->Append(swapTable[i].addrSpace);
+}
+
+void
+MemoryManager::WriteSnapshot(int fd, List<AddrSpace *> *spaces)
+{
+    WriteTable(fd, frameTable, NumPhysPages, spaces);
+    WriteTable(fd, swapTable, numSwapPages, spaces);
+    WriteLong(fd, useClock);
+}
+
+void
+MemoryManager::ReadSnapshot(int fd, AddrSpace **spaces)
+{
+    ReadTable(fd, frameTable, NumPhysPages, spaces);
+    ReadTable(fd, swapTable, numSwapPages, spaces);
+    useClock = ReadLong(fd);
+}
+
+//----------------------------------------------------------------------
+// Snapshot::Snapshot
+// 	Arrange for a snapshot of the machine to be taken.
+//
+//	"fileName" -- where to write it
+//	"when" -- the earliest time to take it
+//----------------------------------------------------------------------
+
+Snapshot::Snapshot(char *fileName, Ticks when)
+{
+    this->fileName = fileName;
+    kernel->machine->CallAtBoundary(this, when);
+}
+
+//----------------------------------------------------------------------
+// Snapshot::CallBack
+// 	Take the snapshot, if the kernel is quiet enough; otherwise try
+//	again after the next tick.
+//----------------------------------------------------------------------
+
+void
+Snapshot::CallBack()
+{
+    if (!IsQuiet()) {
+        kernel->machine->CallAtBoundary(this, 0);
+        return;
+    }
+    Write();
+    cout << "Snapshot written to " << fileName << " at tick "
+         << kernel->stats->totalTicks << "\n";
+}
+
+//----------------------------------------------------------------------
+// Snapshot::IsQuiet
+// 	Return TRUE if the whole state of the kernel is in what Write
+//	saves: no disk request or sleep is pending (the timer is the
+//	only interrupt, if it is still on), and every ready thread runs a user program and
+//	was switched out between two of its instructions.
+//----------------------------------------------------------------------
+
+bool
+Snapshot::IsQuiet()
+{
+    ThreadQueue *readyList = kernel->scheduler->ReadyList();
+
+    if (!kernel->interrupt->OnlyTimerPending() ||
+            !kernel->scheduler->NoOneSleeping() ||
+            (int) readyList->NumInList() != kernel->machine->NumAtBoundary())
+        return FALSE;
+
+    ThreadQueueIterator iter(readyList);
+    for (; !iter.IsDone(); iter.Next())
+        if (iter.Item()->space == NULL)
+            return FALSE;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Snapshot::Write
+// 	Write the state of the machine to the snapshot file.  The
+//	threads are saved in the order they would run: the current one,
+//	then the ready list.  To get at the registers of a ready thread,
+//	they are loaded into the machine for a moment.
+//----------------------------------------------------------------------
+
+void
+Snapshot::Write()
+{
+    Machine *machine = kernel->machine;
+    List<Thread *> *threads = new List<Thread *>;
+    List<AddrSpace *> *spaces = new List<AddrSpace *>;
+    int registers[NumTotalRegs];
+    int fd = OpenForWrite(fileName);
+
+    threads->Append(kernel->currentThread);
+    ThreadQueueIterator readyIter(kernel->scheduler->ReadyList());
+    for (; !readyIter.IsDone(); readyIter.Next())
+        threads->Append(readyIter.Item());
+    ListIterator<Thread *> spaceIter(threads);
+    for (; !spaceIter.IsDone(); spaceIter.Next())
+        if (!spaces->IsInList(spaceIter.Item()->space))
+            spaces->Append(spaceIter.Item()->space);
+    kernel->memoryManager->ListSpaces(spaces);  // and those of dead threads
+
+    WriteInt(fd, SnapshotMagic);
+    WriteInt(fd, NumPhysPages);
+    WriteInt(fd, PageSize);
+    WriteInt(fd, NumSectors);
+    WriteInt(fd, NumTotalRegs);
+
+    if (kernel->interrupt->AnyFutureInterrupts())	// the timer is on
+        WriteLong(fd, kernel->interrupt->TicksUntilNextInterrupt());
+    else
+        WriteLong(fd, -1);
+    WriteFile(fd, (char *) kernel->stats, sizeof(Statistics));
+    WriteFile(fd, machine->mainMemory, MemorySize());
+
+    WriteInt(fd, spaces->NumInList());
+    ListIterator<AddrSpace *> iter(spaces);
+    for (; !iter.IsDone(); iter.Next())
+        iter.Item()->WriteSnapshot(fd);
+    kernel->memoryManager->WriteSnapshot(fd, spaces);
+    kernel->swapDisk->WriteSnapshot(fd);
+
+    WriteInt(fd, threads->NumInList());
+    kernel->currentThread->SaveUserState();
+    ListIterator<Thread *> threadIter(threads);
+    for (; !threadIter.IsDone(); threadIter.Next()) {
+        Thread *t = threadIter.Item();
+        WriteInt(fd, strlen(t->getName()));
+        WriteFile(fd, t->getName(), strlen(t->getName()));
+        WriteInt(fd, SpaceIndex(spaces, t->space));
+        t->RestoreUserState();
+        for (int r = 0; r < NumTotalRegs; r++)
+            registers[r] = machine->ReadRegister(r);
+        WriteFile(fd, (char *) registers, sizeof(registers));
+    }
+    kernel->currentThread->RestoreUserState();
+
+    Close(fd);
+    while (!threads->IsEmpty())
+        threads->RemoveFront();
+    while (!spaces->IsEmpty())
+        spaces->RemoveFront();
+    delete threads;
+    delete spaces;
+}
+
 //----------------------------------------------------------------------
 // UserProgKernel::UserProgKernel
 // 	Interpret command line arguments in order to determine flags 
@@ -197,6 +459,12 @@ UserProgKernel::UserProgKernel(int argc, char **argv)
 		: ThreadedKernel(argc, argv)
 {
     debugUserProg = FALSE;
+    simulatorType = Interpreter;
+    profileFile = NULL;
+    snapshotFile = NULL;
+    snapshot = NULL;
+    restoreFile = NULL;
+    savedStats = NULL;
 	execfileNum=0;
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-s") == 0) {
@@ -204,20 +472,88 @@ UserProgKernel::UserProgKernel(int argc, char **argv)
 	}
 	else if (strcmp(argv[i], "-e") == 0) {
 		execfile[++execfileNum]= argv[++i];
+		execPriority[execfileNum] = DefaultPriority;
+		execTickets[execfileNum] = DefaultTickets;
+	}
+	else if (strcmp(argv[i], "-ep") == 0) {
+	    ASSERT(i + 2 < argc);
+		execfile[++execfileNum]= argv[++i];
+		execPriority[execfileNum] = atoi(argv[++i]);
+		execTickets[execfileNum] = DefaultTickets;
+	}
+	else if (strcmp(argv[i], "-et") == 0) {
+	    ASSERT(i + 2 < argc);
+		execfile[++execfileNum]= argv[++i];
+		execPriority[execfileNum] = DefaultPriority;
+		execTickets[execfileNum] = atoi(argv[++i]);
+	}
+	else if (strcmp(argv[i], "-bb") == 0) {
+	    simulatorType = BlockInterpreter;
+	}
+	else if (strcmp(argv[i], "-jit") == 0) {
+	    simulatorType = BinaryTranslation;
+	}
+	else if (strcmp(argv[i], "-prof") == 0) {
+	    ASSERT(i + 1 < argc);
+	    profileFile = argv[++i];
+	}
+	else if (strcmp(argv[i], "-mem") == 0) {
+	    ASSERT(i + 1 < argc);
+	    int n = atoi(argv[++i]);
+	    if (n <= 0)
+		cout << "-mem needs at least 1 page; ignored" << endl;
+	    else
+		NumPhysPages = n;
+	}
+	else if (strcmp(argv[i], "-pagesize") == 0) {
+	    ASSERT(i + 1 < argc);
+	    int n = atoi(argv[++i]);
+	    if (n <= 0 || n % 4 != 0 || n % SectorSize != 0)
+		cout << "-pagesize needs a positive multiple of 4 and of the sector size; ignored" << endl;
+	    else
+		PageSize = n;
+	}
+	else if (strcmp(argv[i], "-snapshot") == 0) {
+	    ASSERT(i + 2 < argc);
+	    snapshotFile = argv[++i];
+	    snapshotTime = atoll(argv[++i]);
+	}
+	else if (strcmp(argv[i], "-restore") == 0) {
+	    ASSERT(i + 1 < argc);
+	    restoreFile = argv[++i];
 	}
     	 else if (strcmp(argv[i], "-u") == 0) {
 		cout << "===========The following argument is defined in userkernel.cc" << endl;
 		cout << "Partial usage: nachos [-s]\n";
 		cout << "Partial usage: nachos [-u]" << endl;
 		cout << "Partial usage: nachos [-e] filename" << endl;
+		cout << "Partial usage: nachos [-ep] filename priority" << endl;
+		cout << "Partial usage: nachos [-et] filename tickets" << endl;
+		cout << "Partial usage: nachos [-bb]" << endl;
+		cout << "Partial usage: nachos [-jit]" << endl;
+		cout << "Partial usage: nachos [-prof] filename" << endl;
+		cout << "Partial usage: nachos [-mem] pages" << endl;
+		cout << "Partial usage: nachos [-pagesize] bytes" << endl;
+		cout << "Partial usage: nachos [-snapshot] filename ticks" << endl;
+		cout << "Partial usage: nachos [-restore] filename" << endl;
 	}
 	else if (strcmp(argv[i], "-h") == 0) {
 		cout << "argument 's' is for debugging. Machine status  will be printed " << endl;
 		cout << "argument 'e' is for execting file." << endl;
+		cout << "argument 'ep' is for execting file at a priority, from 0 (highest) to " << NumPriorities - 1 << " (default " << DefaultPriority << "); see -PRIORITY." << endl;
+		cout << "argument 'bb' runs user programs a basic block at a time (faster, same results)." << endl;
+		cout << "argument 'jit' translates hot user code into x86-64 code (fastest, same results)." << endl;
+		cout << "argument 'prof' counts every user instruction, prints the hot spots at halt and writes all counts to filename." << endl;
+		cout << "argument 'mem' sets how many pages of physical memory the machine has (default " << DefaultNumPhysPages << ")." << endl;
+		cout << "argument 'pagesize' sets how many bytes are in a page (default " << DefaultPageSize << ")." << endl;
+		cout << "argument 'snapshot' saves the whole machine to filename, once it has run for the given ticks." << endl;
+		cout << "argument 'restore' resumes the programs saved in filename by 'snapshot', instead of running 'e' files." << endl;
 		cout << "atgument 'u' will print all argument usage." << endl;
 		cout << "For example:" << endl;
 		cout << "	./nachos -s : Print machine status during the machine is on." << endl;
 		cout << "	./nachos -e file1 -e file2 : executing file1 and file2."  << endl;
+		cout << "	./nachos -bb -e file1 : executing file1 with the basic block simulator."  << endl;
+		cout << "	./nachos -mem 16 -e file1 : executing file1 with 16 pages of memory."  << endl;
 	}
     }
 }
@@ -232,7 +568,16 @@ UserProgKernel::Initialize()
 {
     ThreadedKernel::Initialize();	// init multithreading
 
-    machine = new Machine(debugUserProg);
+    // snapshots only know how to save a periodic timer, and a ready list
+    // (FCFS or RR)
+    ASSERT(!alarm->IsTickless() || (snapshotFile == NULL && restoreFile == NULL));
+    ASSERT(scheduler->ReadyList() != NULL ||
+           (snapshotFile == NULL && restoreFile == NULL));
+    machine = new Machine(debugUserProg, simulatorType);
+    if (profileFile != NULL)
+	machine->StartProfiling(profileFile);
+    if (snapshotFile != NULL)
+	snapshot = new Snapshot(snapshotFile, snapshotTime);
     fileSystem = new FileSystem();
     swapDisk = new SynchDisk("New SwapDisk");
     memoryManager = new MemoryManager();
@@ -253,6 +598,7 @@ UserProgKernel::~UserProgKernel()
     delete machine;
     delete swapDisk;
     delete memoryManager;
+    delete snapshot;
 #ifdef FILESYS
     delete synchDisk;
 #endif
@@ -268,14 +614,115 @@ ForkExecute(Thread *t)
 	t->space->Execute(t->getName());
 }
 
+//----------------------------------------------------------------------
+// ResumeUser
+// 	Start running a thread's user program where the snapshot left it,
+//	with the registers Restore saved for it.
+//----------------------------------------------------------------------
+
+void
+ResumeUser(Thread *t)
+{
+    kernel->ResumeClock();
+    t->RestoreUserState();
+    t->space->RestoreState();
+    kernel->machine->Run();
+    ASSERTNOTREACHED();
+}
+
+//----------------------------------------------------------------------
+// UserProgKernel::Restore
+// 	Put the machine back the way Snapshot::Write saved it, and fork a
+//	thread to resume each saved user thread, in the order they were
+//	going to run.
+//----------------------------------------------------------------------
+
+void
+UserProgKernel::Restore()
+{
+    int fd = OpenForReadWrite(restoreFile, TRUE);
+    int registers[NumTotalRegs];
+    int numSpaces, numThreads, length;
+    AddrSpace **spaces;
+
+    ASSERT(ReadInt(fd) == SnapshotMagic);
+    ASSERT((unsigned int) ReadInt(fd) == NumPhysPages);	// the snapshot must be of
+    ASSERT((unsigned int) ReadInt(fd) == PageSize);	// the same machine
+    ASSERT(ReadInt(fd) == NumSectors);
+    ASSERT(ReadInt(fd) == NumTotalRegs);
+
+    savedTimerTicks = ReadLong(fd);
+    savedStats = new Statistics();
+    Read(fd, (char *) savedStats, sizeof(Statistics));
+    Read(fd, machine->mainMemory, MemorySize());
+
+    numSpaces = ReadInt(fd);
+    spaces = new AddrSpace *[numSpaces];
+    for (int i = 0; i < numSpaces; i++) {
+	spaces[i] = new AddrSpace();
+	spaces[i]->ReadSnapshot(fd);
+    }
+    memoryManager->ReadSnapshot(fd, spaces);
+    swapDisk->ReadSnapshot(fd);
+
+    numThreads = ReadInt(fd);
+    for (int i = 0; i < numThreads; i++) {
+	length = ReadInt(fd);
+	char *name = new char[length + 1];
+	Read(fd, name, length);
+	name[length] = '\0';
+	Thread *t = new Thread(name);
+	t->space = spaces[ReadInt(fd)];
+	Read(fd, (char *) registers, sizeof(registers));
+	for (int r = 0; r < NumTotalRegs; r++)
+	    machine->WriteRegister(r, registers[r]);
+	t->SaveUserState();
+	t->Fork((VoidFunctionPtr) &ResumeUser, (void *) t);
+	cout << "Thread " << name << " is resumed." << endl;
+    }
+    Close(fd);
+    delete [] spaces;
+}
+
+//----------------------------------------------------------------------
+// UserProgKernel::ResumeClock
+// 	Called by the first thread to resume from a snapshot: set the
+//	statistics, the clock and the timer back to where they were when
+//	it was taken.  (The simulated time spent getting here is lost.)
+//----------------------------------------------------------------------
+
+void
+UserProgKernel::ResumeClock()
+{
+    double hostStartTime = stats->hostStartTime;
+
+    if (savedStats == NULL)		// already done
+	return;
+    *stats = *savedStats;
+    stats->hostStartTime = hostStartTime;
+    if (savedTimerTicks < 0)		// the timer had been turned off
+	interrupt->SetClock(stats->totalTicks, -1);
+    else
+	interrupt->SetClock(stats->totalTicks,
+			    stats->totalTicks + savedTimerTicks);
+    delete savedStats;
+    savedStats = NULL;
+}
+
 void
 UserProgKernel::Run()
 {
+    if (restoreFile != NULL) {
+	Restore();
+	ThreadedKernel::Run();
+    }
 
 	cout << "Total threads number is " << execfileNum << endl;
 	for (int n=1;n<=execfileNum;n++)
 		{
 		t[n] = new Thread(execfile[n]);
+		t[n]->setPriority(execPriority[n]);
+		t[n]->setTickets(execTickets[n]);
 		t[n]->space = new AddrSpace();
 		t[n]->Fork((VoidFunctionPtr) &ForkExecute, (void *)t[n]);
 		cout << "Thread " << execfile[n] << " is executing." << endl;
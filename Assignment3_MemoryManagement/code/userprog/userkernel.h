@@ -16,6 +16,7 @@
 #include "filesys.h"
 #include "machine.h"
 #include "synchdisk.h"
+#include "callback.h"
 #include "list.h"
 class SynchDisk;
 
@@ -26,6 +27,8 @@ class FrameInfoEntry {
         AddrSpace *addrSpace;   // which process is using this page
         unsigned int vpn;       // which virtual page of the process
                                 // is stored in this page
+        unsigned long long lastUsed; // when the page was last referenced,
+                                // for picking the LRU victim
 };
 
 class MemoryManager {
@@ -43,12 +46,51 @@ class MemoryManager {
                 // to frameTable
         void UpdateLRUStack(unsigned int recentlyUsedPage);
         void CheckLock(unsigned int page);
+        void ListSpaces(List<AddrSpace *> *spaces);
+                // add every address space that holds a frame or a
+                // sector to "spaces", if it isn't there yet
+        void WriteSnapshot(int fd, List<AddrSpace *> *spaces);
+        void ReadSnapshot(int fd, AddrSpace **spaces);
+                // save/restore both tables to/from the UNIX file "fd";
+                // address spaces are saved by where they are in "spaces"
     
     private:
         unsigned int KickVictim(bool loadTime = FALSE);
-	    List<unsigned int> *LRUstack;
+        void ReadSwap(unsigned int slot, char *data, bool loadTime);
+        void WriteSwap(unsigned int slot, char *data, bool loadTime);
+                // move a page to/from its slot in swap disk
+        unsigned long long useClock; // counts page references; the frames
+                                    // in use, ordered by lastUsed, form
+                                    // the LRU stack
         FrameInfoEntry *frameTable; // record every physical page's information
-        FrameInfoEntry *swapTable;  // record every sector's information in swapDisk
+        FrameInfoEntry *swapTable;  // record every slot's information in swapDisk
+        unsigned int sectorsPerPage; // a slot is this many sectors,
+        unsigned int numSwapPages;  // and swapDisk has this many slots
+};
+
+// A snapshot of the whole simulated machine: physical memory, the
+// swap disk, page and frame tables, the clock, and every user thread's
+// registers.  A later run can resume from it (-restore) instead of
+// running the programs from the start.
+//
+// The snapshot is taken between two user instructions, once the clock
+// has reached the time asked for and the kernel is quiet: no I/O or
+// sleeping thread pending, and every ready thread switched out between
+// two user instructions too.  The timer is then the only interrupt
+// that can be pending, and the user registers are all the state a
+// thread has.
+
+class Snapshot : public CallBackObj {
+  public:
+    Snapshot(char *fileName, Ticks when);	// Write a snapshot to "fileName"
+					// once the clock reaches "when"
+    void CallBack();			// Called by Machine::Run between two
+					// user instructions
+
+  private:
+    bool IsQuiet();			// Can the snapshot be taken now?
+    void Write();			// Take it
+    char *fileName;			// where it goes
 };
 
 class UserProgKernel : public ThreadedKernel {
@@ -63,6 +105,10 @@ class UserProgKernel : public ThreadedKernel {
 
     void SelfTest();		// test whether kernel is working
 
+    void ResumeClock();		// The first thread resumed from a
+				// snapshot sets the clock and statistics
+				// back to what they were
+
 // These are public for notational convenience.
     Machine *machine;
     FileSystem *fileSystem;
@@ -76,8 +122,20 @@ class UserProgKernel : public ThreadedKernel {
 
   private:
     bool debugUserProg;		// single step user program
+    SimulatorType simulatorType; // how the machine runs user instructions
+    char *profileFile;		// where to write the profile, or NULL
+    char *snapshotFile;		// where to write a snapshot, or NULL
+    Ticks snapshotTime;		// and when
+    Snapshot *snapshot;
+    char *restoreFile;		// snapshot to resume from, or NULL
+    Statistics *savedStats;	// statistics and time to the next timer
+    Ticks savedTimerTicks;	// interrupt, when the snapshot was taken
+
+    void Restore();		// Start the threads saved in restoreFile
 	Thread* t[10];
 	char*	execfile[10];
+	int	execPriority[10];	// the priority to run each file at
+	int	execTickets[10];	// and its tickets, for stride scheduling
 	int	execfileNum;
 };
 
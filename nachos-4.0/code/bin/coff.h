@@ -47,3 +47,52 @@ struct scnhdr {
         long            s_flags;        /* flags */
       };
  
+
+/* The symbolic header, found at f_symptr.  We only use it to find the
+ * external symbols and their names.
+ */
+typedef struct hdrr {
+        short   magic;          /* to verify validity of the table      */
+        short   vstamp;         /* version stamp                        */
+        long    ilineMax;       /* number of line number entries        */
+        long    cbLine;         /* number of bytes for line numbers     */
+        long    cbLineOffset;   /* offset to start of line numbers      */
+        long    idnMax;         /* max index into dense numbers         */
+        long    cbDnOffset;     /* offset to start dense numbers        */
+        long    ipdMax;         /* number of procedures                 */
+        long    cbPdOffset;     /* offset to procedure descriptors      */
+        long    isymMax;        /* number of local symbols              */
+        long    cbSymOffset;    /* offset to start of local symbols     */
+        long    ioptMax;        /* max index into optimization entries  */
+        long    cbOptOffset;    /* offset to optimization entries       */
+        long    iauxMax;        /* number of auxiliary symbols          */
+        long    cbAuxOffset;    /* offset to start of auxiliary symbols */
+        long    issMax;         /* max index into local strings         */
+        long    cbSsOffset;     /* offset to start of local strings     */
+        long    issExtMax;      /* max index into external strings      */
+        long    cbSsExtOffset;  /* offset to start of external strings  */
+        long    ifdMax;         /* number of file descriptors           */
+        long    cbFdOffset;     /* offset to file descriptors           */
+        long    crfd;           /* number of relative file descriptors  */
+        long    cbRfdOffset;    /* offset to relative file descriptors  */
+        long    iextMax;        /* number of external symbols           */
+        long    cbExtOffset;    /* offset to start of external symbols  */
+      } HDRR;
+
+/* An external symbol.  "bits" packs the symbol type (st), storage
+ * class (sc) and index; use the macros below to pick them out.
+ */
+typedef struct extr {
+        short   reserved;
+        short   ifd;            /* file the symbol was defined in       */
+        long    iss;            /* index of its name in the strings     */
+        long    value;          /* its address, for procedures          */
+        unsigned long bits;     /* st:6, sc:5, reserved:1, index:20     */
+      } EXTR;
+
+#define SymType(bits)   ((bits) & 0x3f)
+#define SymClass(bits)  (((bits) >> 6) & 0x1f)
+
+#define stProc          6       /* a procedure                          */
+#define stStaticProc    14      /* a static procedure                   */
+#define scText          1       /* in the text segment                  */
@@ -15,6 +15,10 @@
  *	.data	-- initialized data
  *	.bss/.sbss -- uninitialized data (should be zero'd on program startup)
  *
+ * If a third file name is given, the procedures in the text segment are
+ * written to it, one per line (address in hex, then name), in address
+ * order.  The Nachos profiler reads this from "<noffFileName>.sym".
+ *
  * Copyright (c) 1992-1993 The Regents of the University of California.
  * All rights reserved.  See copyright.h for copyright notice and limitation 
  * of liability and disclaimer of warranty provisions.
@@ -89,6 +93,59 @@ void Write(int fd, char *buf, int nBytes)
     }
 }
 
+/* write the procedures in the COFF file's external symbols to "symFileName" */
+void WriteSymbols(int fdIn, struct filehdr *fileh, char *symFileName)
+{
+    HDRR symhdr;
+    EXTR *syms;
+    char *strings;
+    FILE *out;
+    int i, j, n, numSyms;
+    EXTR tmp;
+
+    if (fileh->f_symptr == 0) {
+	fprintf(stderr, "No symbol table; not writing %s\n", symFileName);
+	return;
+    }
+    lseek(fdIn, fileh->f_symptr, 0);
+    ReadStruct(fdIn, symhdr);
+    numSyms = WordToHost(symhdr.iextMax);
+    syms = (EXTR *)malloc(numSyms * sizeof(EXTR));
+    lseek(fdIn, WordToHost(symhdr.cbExtOffset), 0);
+    Read(fdIn, (char *) syms, numSyms * sizeof(EXTR));
+    strings = malloc(WordToHost(symhdr.issExtMax));
+    lseek(fdIn, WordToHost(symhdr.cbSsExtOffset), 0);
+    Read(fdIn, strings, WordToHost(symhdr.issExtMax));
+
+    /* keep the procedures in the text segment, sorted by address */
+    for (i = 0, n = 0; i < numSyms; i++) {
+	syms[i].iss = WordToHost(syms[i].iss);
+	syms[i].value = WordToHost(syms[i].value);
+	syms[i].bits = WordToHost(syms[i].bits);
+	if ((SymType(syms[i].bits) != stProc
+			&& SymType(syms[i].bits) != stStaticProc)
+		|| SymClass(syms[i].bits) != scText)
+	    continue;
+	tmp = syms[i];
+	for (j = n; j > 0 && syms[j - 1].value > tmp.value; j--)
+	    syms[j] = syms[j - 1];
+	syms[j] = tmp;
+	n++;
+    }
+
+    out = fopen(symFileName, "w");
+    if (out == NULL) {
+	perror(symFileName);
+	exit(1);
+    }
+    for (i = 0; i < n; i++)
+	fprintf(out, "%x %s\n", (unsigned int) syms[i].value,
+		&strings[syms[i].iss]);
+    fclose(out);
+    free(syms);
+    free(strings);
+}
+
 main (int argc, char **argv)
 {
     int fdIn, fdOut, numsections, i, inNoffFile;
@@ -99,7 +156,7 @@ main (int argc, char **argv)
     NoffHeader noffH;
 
     if (argc < 2) {
-	fprintf(stderr, "Usage: %s <coffFileName> <noffFileName>\n", argv[0]);
+	fprintf(stderr, "Usage: %s <coffFileName> <noffFileName> [<symFileName>]\n", argv[0]);
 	exit(1);
     }
     
@@ -221,6 +278,10 @@ main (int argc, char **argv)
     }
     lseek(fdOut, 0, 0);
     Write(fdOut, (char *)&noffH, sizeof(NoffHeader));
+    if (argc > 3) {
+	fileh.f_symptr = WordToHost(fileh.f_symptr);
+	WriteSymbols(fdIn, &fileh, argv[3]);
+    }
     close(fdIn);
     close(fdOut);
     exit(0);
@@ -0,0 +1,335 @@
+// heap.cc
+//     	Routines to manage a priority queue, kept as a binary heap.
+//	See heap.h for what it does.
+//
+//     	NOTE: this file is included by heap.h, like list.cc is by
+//	list.h, so it is not compiled separately.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+const int InitialHeapSize = 16;	// items a heap has room for at first
+
+template <class T> T *Heap<T>::testItems = NULL;
+template <class T> int *Heap<T>::testPlaces = NULL;
+template <class T> int Heap<T>::numTestItems = 0;
+
+//----------------------------------------------------------------------
+// Heap<T>::Heap
+//	Initialize an empty heap.
+//
+//	"comp" -- function for ordering items: returns -1 if x is smaller
+//		than y, 1 if it is larger, 0 if they are equal
+//	"place" -- if not NULL, function to tell an item its index in
+//		the heap whenever that changes (-1 once it is removed)
+//----------------------------------------------------------------------
+
+template <class T>
+Heap<T>::Heap(int (*comp)(T x, T y), void (*place)(T x, int i))
+{
+    compare = comp;
+    placed = place;
+    size = InitialHeapSize;
+    items = new T[size];
+    numInHeap = 0;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::~Heap
+//	De-allocate the heap.  As with lists, the caller is responsible
+//	for the items on it.
+//----------------------------------------------------------------------
+
+template <class T>
+Heap<T>::~Heap()
+{
+    delete [] items;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Insert
+//	Put an item on the heap, making room for it if need be.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::Insert(T item)
+{
+    if (numInHeap == size) {		// full; double the array
+	T *newItems = new T[size * 2];
+	for (int i = 0; i < numInHeap; i++)
+	    newItems[i] = items[i];
+	delete [] items;
+	items = newItems;
+	size *= 2;
+    }
+    Put(item, numInHeap);
+    SiftUp(numInHeap++);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::RemoveFront
+//	Remove the smallest item from the heap, and return it.
+//	The heap must not be empty.
+//----------------------------------------------------------------------
+
+template <class T>
+T
+Heap<T>::RemoveFront()
+{
+    return Remove(0);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Remove
+//	Remove the item at index "i" of the heap, and return it.  The
+//	last item takes its place, and is moved up or down from there.
+//----------------------------------------------------------------------
+
+template <class T>
+T
+Heap<T>::Remove(int i)
+{
+    T item;
+
+    ASSERT(i >= 0 && i < numInHeap);
+    item = items[i];
+    if (placed != NULL)
+	(*placed)(item, -1);
+    if (i < --numInHeap) {
+	Put(items[numInHeap], i);
+	Changed(i);
+    }
+    return item;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Changed
+//	The item at index "i" may now compare differently with the
+//	others; move it up or down to where it belongs.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::Changed(int i)
+{
+    ASSERT(i >= 0 && i < numInHeap);
+    if (i > 0 && compare(items[i], items[(i - 1) / 2]) < 0)
+	SiftUp(i);
+    else
+	SiftDown(i);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Put
+//	Store "item" at index "i", telling it so if need be.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::Put(T item, int i)
+{
+    items[i] = item;
+    if (placed != NULL)
+	(*placed)(item, i);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SiftUp
+//	Move items[i] towards the top, until its parent is no larger.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::SiftUp(int i)
+{
+    T item = items[i];
+    int parent;
+
+    while (i > 0) {
+	parent = (i - 1) / 2;
+	if (compare(item, items[parent]) >= 0)
+	    break;
+	Put(items[parent], i);
+	i = parent;
+    }
+    Put(item, i);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SiftDown
+//	Move items[i] towards the bottom, until neither of its children
+//	is smaller.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::SiftDown(int i)
+{
+    T item = items[i];
+    int child;
+
+    for (;;) {
+	child = 2 * i + 1;
+	if (child >= numInHeap)
+	    break;
+	if (child + 1 < numInHeap && compare(items[child + 1], items[child]) < 0)
+	    child++;			// the smaller child
+	if (compare(items[child], item) >= 0)
+	    break;
+	Put(items[child], i);
+	i = child;
+    }
+    Put(item, i);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Apply
+//	Apply function to every item on the heap, in the order they are
+//	kept in the array (not sorted).
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::Apply(void (*func)(T)) const
+{
+    for (int i = 0; i < numInHeap; i++)
+	(*func)(items[i]);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SanityCheck
+//	Check that every item is no smaller than its parent.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::SanityCheck() const
+{
+    ASSERT(numInHeap >= 0 && numInHeap <= size);
+    for (int i = 1; i < numInHeap; i++)
+	ASSERT(compare(items[(i - 1) / 2], items[i]) <= 0);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::TestPlaced
+//	The "placed" function used by SelfTest: note that item "x" was
+//	told it is at index "i".
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::TestPlaced(T x, int i)
+{
+    for (int k = 0; k < numTestItems; k++) {
+	if (testItems[k] == x) {
+	    testPlaces[k] = i;
+	    return;
+	}
+    }
+    ASSERTNOTREACHED();			// not one of the test's items
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::CheckPlaces
+//	Check that every item on the heap is where it was last told it
+//	is, and that every other item was told it is off the heap.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::CheckPlaces() const
+{
+    int numPlaced = 0;
+
+    for (int k = 0; k < numTestItems; k++) {
+	if (testPlaces[k] >= 0) {
+	    ASSERT(testPlaces[k] < numInHeap);
+	    ASSERT(items[testPlaces[k]] == testItems[k]);
+	    numPlaced++;
+	}
+    }
+    ASSERT(numPlaced == numInHeap);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SelfTest
+//      Test whether this module is working.  "p" holds "numEntries"
+//	different items, at least 3, in any order; the heap must be
+//	empty.  While it runs, the items are told where they are by
+//	TestPlaced, instead of by the heap's own "placed" function.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::SelfTest(T *p, int numEntries)
+{
+    void (*oldPlaced)(T x, int i) = placed;
+    T item, smallest = p[0], largest = p[0];
+    int i;
+
+    ASSERT(IsEmpty() && numEntries >= 3);
+    testItems = p;
+    testPlaces = new int[numEntries];
+    numTestItems = numEntries;
+    for (i = 0; i < numEntries; i++)
+	testPlaces[i] = -1;
+    placed = TestPlaced;
+
+    // should get out everything we put in, smallest first
+    for (i = 0; i < numEntries; i++) {
+	Insert(p[i]);
+	SanityCheck();
+	CheckPlaces();
+    }
+    ASSERT(NumInHeap() == numEntries);
+    for (i = 0; i < numEntries; i++) {
+	item = RemoveFront();
+	if (i == 0)
+	    smallest = item;
+	else
+	    ASSERT(compare(largest, item) <= 0);
+	largest = item;
+	SanityCheck();
+	CheckPlaces();
+    }
+    ASSERT(IsEmpty());
+
+    // take the largest item out of wherever it is
+    for (i = 0; i < numEntries; i++)
+	Insert(p[i]);
+    for (i = 0; p[i] != largest; i++)
+	;
+    ASSERT(Remove(testPlaces[i]) == largest);
+    SanityCheck();
+    CheckPlaces();
+
+    // have the smallest item become the largest: it moves down
+    (*placed)(items[0], -1);
+    Put(largest, 0);
+    Changed(0);
+    ASSERT(Front() != largest);
+    SanityCheck();
+    CheckPlaces();
+
+    // and the item at the bottom become the smallest: it moves up
+    (*placed)(items[numInHeap - 1], -1);
+    Put(smallest, numInHeap - 1);
+    Changed(numInHeap - 1);
+    ASSERT(Front() == smallest);
+    SanityCheck();
+    CheckPlaces();
+
+    while (!IsEmpty())
+	RemoveFront();
+    CheckPlaces();
+
+    placed = oldPlaced;
+    delete [] testPlaces;
+    testPlaces = NULL;
+    testItems = NULL;
+    numTestItems = 0;
+}
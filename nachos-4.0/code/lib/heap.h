@@ -0,0 +1,89 @@
+// heap.h
+//	Data structures to manage a priority queue, as a binary heap.
+//
+//	Like a SortedList, a heap keeps its items ordered by a comparison
+//	function, but only as far as needed to find the smallest one:
+//	inserting an item or removing the smallest takes O(log n) time,
+//	instead of O(n).  Items that compare equal come out in no
+//	particular order; if that matters, the comparison function
+//	has to break the tie (for instance, by when the items were
+//	inserted).
+//
+//	An item can also be taken out of the middle of the heap, or have
+//	its key changed, in O(log n) time, if the heap is told where the
+//	item is; for that, the heap can be given a function that it calls
+//	every time an item moves, to keep track of its place.
+//
+//	As with lists, allocation and deallocation of the items on the
+//	heap are to be done by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef HEAP_H
+#define HEAP_H
+
+#include "copyright.h"
+#include "debug.h"
+
+// The following class defines a heap of items of type T, smallest
+// first according to "compare" (which returns -1, 0, or 1, as for
+// SortedList).  The items are kept in an array, which is doubled
+// when it fills up.  If "place" is given, it is called with an item's
+// new index every time the item is put in the array, and with -1 when
+// the item is taken off the heap.
+
+template <class T>
+class Heap {
+  public:
+    Heap(int (*comp)(T x, T y), void (*place)(T x, int i) = NULL);
+					// initialize the heap
+    ~Heap();				// de-allocate the heap
+
+    void Insert(T item);		// put an item on the heap
+    T RemoveFront();			// remove the smallest item
+    T Remove(int i);			// remove the item at index "i"
+    void Changed(int i);		// the key of the item at index
+					// "i" has changed; put it in
+					// its new place
+    T Front() { ASSERT(numInHeap > 0); return items[0]; }
+					// return the smallest item,
+					// without removing it
+
+    bool IsEmpty() { return numInHeap == 0; }
+    int NumInHeap() { return numInHeap; }
+
+    void Apply(void (*f)(T)) const;	// apply function to all items,
+					// in no particular order
+
+    void SanityCheck() const;		// is every item no smaller
+					// than its parent?
+    void SelfTest(T *p, int numEntries);
+					// verify module is working
+
+  private:
+    T *items;				// the heap: items[i] is no larger
+					// than items[2i+1] and items[2i+2]
+    int numInHeap;			// number of items on the heap
+    int size;				// number of items there is room for
+    int (*compare)(T x, T y);		// function for ordering items
+    void (*placed)(T x, int i);		// function to tell an item
+					// where it is, or NULL
+
+    void SiftUp(int i);			// move items[i] up to its place
+    void SiftDown(int i);		// move items[i] down to its place
+    void Put(T item, int i);		// store item at items[i]
+
+					// for SelfTest:
+    static T *testItems;		// the items it puts on the heap
+    static int *testPlaces;		// where each was last told it is
+    static int numTestItems;
+    static void TestPlaced(T x, int i);	// note where "x" was told it is
+    void CheckPlaces() const;		// is each item where it was told?
+};
+
+#include "heap.cc"		// templates are really like macros
+				// so needs to be included in every
+				// file that uses the template
+#endif // HEAP_H
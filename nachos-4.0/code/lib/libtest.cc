@@ -1,6 +1,7 @@
 // libtest.cc 
 //	Driver code to call self-test routines for standard library
-//	classes -- bitmaps, lists, sorted lists, and hash tables.
+//	classes -- bitmaps, lists, sorted lists (both kinds of each),
+//	hash tables, and heaps.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -11,6 +12,7 @@
 #include "bitmap.h"
 #include "list.h"
 #include "hash.h"
+#include "heap.h"
 #include "sysdep.h"
 
 //----------------------------------------------------------------------
@@ -26,6 +28,25 @@ IntCompare(int x, int y) {
     else return 1;
 }
 
+// An integer that can be put on an intrusive list, for testing
+// IntrusiveLists and IntrusiveSortedLists.
+
+class IntItem {
+  public:
+    int value;
+    ListLink<IntItem> link;
+};
+
+//----------------------------------------------------------------------
+// IntItemCompare
+//	Compare two IntItems by their values.
+//----------------------------------------------------------------------
+
+static int 
+IntItemCompare(IntItem *x, IntItem *y) {
+    return IntCompare(x->value, y->value);
+}
+
 //----------------------------------------------------------------------
 // HashInt, HashKey
 //	Compute a hash function on an integer.  Serves as the
@@ -53,6 +74,11 @@ HashKey(char *str) {
 // Array of values to be inserted into a List or SortedList. 
 static int listTestVector[] = { 9, 5, 7 };
 
+// Array of values to be inserted into a Heap.  There are enough
+// here to make it grow.
+static int heapTestVector[] = { 9, 5, 7, 17, 3, 12, 8, 19, 1, 14, 6, 0,
+	 16, 2, 11, 4, 18, 10, 15, 13 };
+
 // Array of values to be inserted into the HashTable
 // There are enough here to force a ReHash().
 static char *hashTestVector[] = { "0", "1", "2", "3", "4", "5", "6",
@@ -60,8 +86,8 @@ static char *hashTestVector[] = { "0", "1", "2", "3", "4", "5", "6",
 
 //----------------------------------------------------------------------
 // LibSelfTest
-//	Run self tests on bitmaps, lists, sorted lists, and 
-//	hash tables.
+//	Run self tests on bitmaps, lists, sorted lists, hash tables,
+//	and heaps.
 //----------------------------------------------------------------------
 
 void
@@ -69,17 +95,35 @@ LibSelfTest () {
     BitMap *map = new BitMap(200);
     List<int> *list = new List<int>;
     SortedList<int> *sortList = new SortedList<int>(IntCompare);
+    IntrusiveList<IntItem, &IntItem::link> *iList =
+	new IntrusiveList<IntItem, &IntItem::link>;
+    IntrusiveSortedList<IntItem, &IntItem::link> *iSortList =
+	new IntrusiveSortedList<IntItem, &IntItem::link>(IntItemCompare);
     HashTable<int, char *> *hashTable = 
 	new HashTable<int, char *>(HashKey, HashInt);
+    Heap<int> *heap = new Heap<int>(IntCompare);
+    const int numItems = sizeof(listTestVector)/sizeof(int);
+    IntItem items[numItems];
+    IntItem *itemPtrs[numItems];
 	
+    for (int i = 0; i < numItems; i++) {
+	items[i].value = listTestVector[i];
+	itemPtrs[i] = &items[i];
+    }
 		
     map->SelfTest();
     list->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
     sortList->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
+    iList->SelfTest(itemPtrs, numItems);
+    iSortList->SelfTest(itemPtrs, numItems);
     hashTable->SelfTest(hashTestVector, sizeof(hashTestVector)/sizeof(char *));
+    heap->SelfTest(heapTestVector, sizeof(heapTestVector)/sizeof(int));
 
     delete map;
     delete list;
     delete sortList;
+    delete iList;
+    delete iSortList;
     delete hashTable;
+    delete heap;
 }
@@ -7,6 +7,10 @@
 //	list; it is de-allocated when the item is removed. This means
 //      we don't need to keep a "next" pointer in every object we
 //      want to put on a list.
+//
+//	An "IntrusiveList" is the other way around: each object keeps
+//	its own ListLink, so nothing is allocated or de-allocated as it
+//	goes on and off the list.
 // 
 //     	NOTE: Mutual exclusion must be provided by the caller.
 //  	If you want a synchronized list, you must use the routines 
@@ -74,7 +78,7 @@ List<T>::Append(T item)
 {
     ListElement<T> *element = new ListElement<T>(item);
 
-    ASSERT(!IsInList(item));
+    PARANOID_ASSERT(!IsInList(item));
     if (IsEmpty()) {		// list is empty
 	first = element;
 	last = element;
@@ -83,7 +87,7 @@ List<T>::Append(T item)
 	last = element;
     }
     numInList++;
-    ASSERT(IsInList(item));
+    PARANOID_ASSERT(IsInList(item));
 }
 
 //----------------------------------------------------------------------
@@ -97,7 +101,7 @@ List<T>::Prepend(T item)
 {
     ListElement<T> *element = new ListElement<T>(item);
 
-    ASSERT(!IsInList(item));
+    PARANOID_ASSERT(!IsInList(item));
     if (IsEmpty()) {		// list is empty
 	first = element;
 	last = element;
@@ -106,7 +110,7 @@ List<T>::Prepend(T item)
 	first = element;
     }
     numInList++;
-    ASSERT(IsInList(item));
+    PARANOID_ASSERT(IsInList(item));
 }
 
 //----------------------------------------------------------------------
@@ -151,7 +155,8 @@ List<T>::Remove(T item)
     ListElement<T> *prev, *ptr;
     T removed;
 
-    ASSERT(IsInList(item));
+    ASSERT(!IsEmpty());
+    PARANOID_ASSERT(IsInList(item));
 
     // if first item on list is match, then remove from front
     if (item == first->item) {	
@@ -172,7 +177,7 @@ List<T>::Remove(T item)
         }
 	ASSERT(ptr != NULL);	// should always find item!
     }
-   ASSERT(!IsInList(item));
+   PARANOID_ASSERT(!IsInList(item));
 }
 
 //----------------------------------------------------------------------
@@ -234,7 +239,7 @@ SortedList<T>::Insert(T item)
     ListElement<T> *element = new ListElement<T>(item);
     ListElement<T> *ptr;		// keep track
 
-    ASSERT(!this->IsInList(item));
+    PARANOID_ASSERT(!this->IsInList(item));
     if (this->IsEmpty()) {			// if list is empty, put at front
         this->first = element;
         this->last = element;
@@ -254,7 +259,7 @@ SortedList<T>::Insert(T item)
 	this->last = element;
     }
     this->numInList++;
-    ASSERT(this->IsInList(item));
+    PARANOID_ASSERT(this->IsInList(item));
 }
 
 //----------------------------------------------------------------------
@@ -379,3 +384,356 @@ SortedList<T>::SelfTest(T *p, int numEntries)
 
      delete q;
 }
+
+//----------------------------------------------------------------------
+// IntrusiveList<T, Link>::IntrusiveList
+//	Initialize an intrusive list, empty to start with.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+IntrusiveList<T, Link>::IntrusiveList()
+{ 
+    first = last = NULL; 
+    numInList = 0;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T, Link>::~IntrusiveList
+//	Prepare a list for deallocation.  Unlike a List, it need not be
+//	empty: the list owns no storage, so any items left on it (say,
+//	the threads still ready when Nachos halts) are simply forgotten.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+IntrusiveList<T, Link>::~IntrusiveList()
+{ 
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T, Link>::Append
+//      Append an "item" to the end of the list.  It must not be on
+//	any list linked through the same ListLink.
+//
+//	"item" is the thing to put on the list.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+void
+IntrusiveList<T, Link>::Append(T *item)
+{
+    ListLink<T> *link = LinkOf(item);
+
+    ASSERT(link->next == NULL && link->prev == NULL && first != item);
+    PARANOID_ASSERT(!IsInList(item));
+    if (IsEmpty()) {		// list is empty
+	first = item;
+    } else {			// else put it after last
+	link->prev = last;
+	LinkOf(last)->next = item;
+    }
+    last = item;
+    numInList++;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T, Link>::Prepend
+//	Same as Append, only put "item" on the front.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+void
+IntrusiveList<T, Link>::Prepend(T *item)
+{
+    ListLink<T> *link = LinkOf(item);
+
+    ASSERT(link->next == NULL && link->prev == NULL && first != item);
+    PARANOID_ASSERT(!IsInList(item));
+    if (IsEmpty()) {		// list is empty
+	last = item;
+    } else {			// else put it before first
+	link->next = first;
+	LinkOf(first)->prev = item;
+    }
+    first = item;
+    numInList++;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T, Link>::RemoveFront
+//      Remove the first "item" from the front of the list.
+//	List must not be empty.
+// 
+// Returns:
+//	The removed item.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+T *
+IntrusiveList<T, Link>::RemoveFront()
+{
+    T *thing = first;
+
+    ASSERT(!IsEmpty());
+    Remove(thing);
+    return thing;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T, Link>::Remove
+//      Remove a specific item from the list.  Must be in the list!
+//	Its own links say where it is, so there is no need to search.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+void
+IntrusiveList<T, Link>::Remove(T *item)
+{
+    ListLink<T> *link = LinkOf(item);
+
+    PARANOID_ASSERT(IsInList(item));
+    if (link->prev == NULL) {	// it is first
+	ASSERT(first == item);
+	first = link->next;
+    } else {
+	LinkOf(link->prev)->next = link->next;
+    }
+    if (link->next == NULL) {	// it is last
+	ASSERT(last == item);
+	last = link->prev;
+    } else {
+	LinkOf(link->next)->prev = link->prev;
+    }
+    link->next = link->prev = NULL;
+    numInList--;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T, Link>::Concatenate
+//      Move every item on "other" to the end of this list, keeping
+//	their order, and leave "other" empty.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+void
+IntrusiveList<T, Link>::Concatenate(IntrusiveList *other)
+{
+    ASSERT(other != this);
+    if (other->IsEmpty()) {
+	return;
+    }
+    if (IsEmpty()) {
+	first = other->first;
+    } else {
+	LinkOf(last)->next = other->first;
+	LinkOf(other->first)->prev = last;
+    }
+    last = other->last;
+    numInList += other->numInList;
+    other->first = other->last = NULL;
+    other->numInList = 0;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T, Link>::IsInList
+//      Return TRUE if the item is in the list.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+bool
+IntrusiveList<T, Link>::IsInList(T *item) const
+{ 
+    T *ptr;
+
+    for (ptr = first; ptr != NULL; ptr = LinkOf(ptr)->next) {
+        if (item == ptr) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T, Link>::Apply
+//      Apply function to every item on a list.
+//
+//	"func" -- the function to apply
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+void
+IntrusiveList<T, Link>::Apply(void (*func)(T *)) const
+{ 
+    T *ptr;
+
+    for (ptr = first; ptr != NULL; ptr = LinkOf(ptr)->next) {
+        (*func)(ptr);
+    }
+}
+
+//----------------------------------------------------------------------
+// IntrusiveSortedList::Insert
+//      Insert an "item" into a list, so that the list elements are
+//	sorted in increasing order; after any equal to it.
+//      
+//	Walk through the list, one element at a time, to find where
+//	the new item should be placed.
+//
+//	"item" is the thing to put on the list. 
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+void
+IntrusiveSortedList<T, Link>::Insert(T *item)
+{
+    ListLink<T> *link = this->LinkOf(item);
+    T *ptr;
+
+    ASSERT(link->next == NULL && link->prev == NULL && this->first != item);
+    PARANOID_ASSERT(!this->IsInList(item));
+    for (ptr = this->last; ptr != NULL; ptr = this->LinkOf(ptr)->prev) {
+	if (compare(item, ptr) >= 0) {	// item goes after ptr
+	    break;
+	}
+    }
+    if (ptr == NULL) {			// item goes at front
+	IntrusiveList<T, Link>::Prepend(item);
+    } else if (ptr == this->last) {	// item goes at end
+	IntrusiveList<T, Link>::Append(item);
+    } else {
+	link->prev = ptr;
+	link->next = this->LinkOf(ptr)->next;
+	this->LinkOf(link->next)->prev = item;
+	this->LinkOf(ptr)->next = item;
+	this->numInList++;
+    }
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList::SanityCheck
+//      Test whether this is still a legal list.
+//
+//	Tests: do I get to last starting from first, and back?
+//	       does the list have the right # of elements?
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+void 
+IntrusiveList<T, Link>::SanityCheck() const
+{
+    T *prev, *ptr;
+    int numFound = 0;
+
+    if (first == NULL) {
+	ASSERT((numInList == 0) && (last == NULL));
+    } else {
+	ASSERT(LinkOf(first)->prev == NULL);
+        for (prev = NULL, ptr = first; ptr != NULL; 
+				prev = ptr, ptr = LinkOf(ptr)->next) {
+	    numFound++;
+            ASSERT(numFound <= numInList);	// prevent infinite loop
+	    ASSERT(LinkOf(ptr)->prev == prev);
+        }
+        ASSERT(numFound == numInList);
+        ASSERT(prev == last);
+    }
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList::SelfTest
+//      Test whether this module is working.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+void 
+IntrusiveList<T, Link>::SelfTest(T **p, int numEntries)
+{
+    int i;
+    IntrusiveListIterator<T, Link> *iterator = 
+				new IntrusiveListIterator<T, Link>(this);
+
+    SanityCheck();
+    // check various ways that list is empty
+    ASSERT(IsEmpty() && (first == NULL));
+    for (; !iterator->IsDone(); iterator->Next()) {
+	ASSERTNOTREACHED();	// nothing on list
+    }
+
+    for (i = 0; i < numEntries; i++) {
+	 Append(p[i]);
+	 ASSERT(IsInList(p[i]));
+	 ASSERT(!IsEmpty());
+     }
+     SanityCheck();
+
+     // should be able to get out everything we put in, from
+     // anywhere on the list
+     for (i = 0; i < numEntries - 1; i++) {
+	 Remove(p[i]);
+         ASSERT(!IsInList(p[i]));
+	 SanityCheck();
+     }
+     if (numEntries > 0) {
+	 ASSERT(RemoveFront() == p[numEntries - 1]);
+     }
+     ASSERT(IsEmpty());
+     SanityCheck();
+     delete iterator;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveSortedList::SanityCheck
+//      Test whether this is still a legal sorted list.
+//
+//	Test: is the list sorted?
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+void 
+IntrusiveSortedList<T, Link>::SanityCheck() const
+{
+    T *prev, *ptr;
+
+    IntrusiveList<T, Link>::SanityCheck();
+    if (this->first != this->last) {
+        for (prev = this->first, ptr = this->LinkOf(prev)->next; ptr != NULL; 
+				prev = ptr, ptr = this->LinkOf(ptr)->next) {
+            ASSERT(compare(prev, ptr) <= 0);
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// IntrusiveSortedList::SelfTest
+//      Test whether this module is working.
+//----------------------------------------------------------------------
+
+template <class T, ListLink<T> T::*Link>
+void 
+IntrusiveSortedList<T, Link>::SelfTest(T **p, int numEntries)
+{
+    int i;
+    T **q = new T*[numEntries];
+
+    IntrusiveList<T, Link>::SelfTest(p, numEntries);
+
+    for (i = 0; i < numEntries; i++) {
+	 Insert(p[i]);
+	 ASSERT(this->IsInList(p[i]));
+     }
+     SanityCheck();
+
+     // should be able to get out everything we put in
+     for (i = 0; i < numEntries; i++) {
+	 q[i] = this->RemoveFront();
+         ASSERT(!this->IsInList(q[i]));
+     }
+     ASSERT(this->IsEmpty());
+
+     // make sure everything came out in the right order
+     for (i = 0; i < (numEntries - 1); i++) {
+	 ASSERT(compare(q[i], q[i + 1]) <= 0);
+     }
+     SanityCheck();
+
+     delete [] q;
+}
@@ -6,6 +6,15 @@
 //	pending interrupts, etc.  Allocation and deallocation of the
 //	items on the list are to be done by the caller.
 //
+//	An "intrusive" list is threaded through the items themselves,
+//	each of which has a ListLink for it, so that putting an item on
+//	the list and taking it off allocate nothing, and take the same
+//	time however long the list is.
+//
+//	Checking whether an item is on a list means walking the list,
+//	so insertions and removals only check that in a paranoid build
+//	(see PARANOID_ASSERT in debug.h).
+//
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -136,6 +145,125 @@ class ListIterator {
     ListElement<T> *current;	// where we are in the list
 };
 
+// The following class defines the links that an object needs, to be
+// put on an "intrusive list" -- a doubly linked list threaded through
+// the objects themselves, rather than through ListElements.  An object
+// can be on as many intrusive lists at a time as it has ListLinks.
+//
+// Both links are NULL while the object is on no list.
+
+template <class T>
+class ListLink {
+  public:
+    ListLink() { next = prev = NULL; }
+    T *next;			// next item on the list, NULL if this is last
+    T *prev;			// previous item, NULL if this is first
+};
+
+// The following class defines an intrusive list of objects of class
+// T, linked through the ListLink member "Link" of each object, as in:
+//
+//	IntrusiveList<Thread, &Thread::queueLink> readyList;
+//
+// It has the same operations as List, but an item can be removed
+// from anywhere on the list without searching for it.
+
+template <class T, ListLink<T> T::*Link>
+class IntrusiveListIterator;
+
+template <class T, ListLink<T> T::*Link>
+class IntrusiveList {
+  public:
+    IntrusiveList();		// initialize the list
+    virtual ~IntrusiveList();	// de-allocate the list
+
+    virtual void Prepend(T *item);// Put item at the beginning of the list
+    virtual void Append(T *item); // Put item at the end of the list
+
+    T *Front() { return first; }
+    				// Return first item on list
+				// without removing it; NULL if none
+    T *RemoveFront(); 		// Take item off the front of the list
+    void Remove(T *item); 	// Remove specific item from list
+    void Concatenate(IntrusiveList *other);
+    				// Move every item of "other" to the
+				// end of this list, in order
+
+    bool IsInList(T *item) const;// is the item in the list?
+
+    unsigned int NumInList() { return numInList;};
+    				// how many items in the list?
+    bool IsEmpty() { return (numInList == 0); };
+    				// is the list empty? 
+
+    void Apply(void (*f)(T *)) const; 
+    				// apply function to all elements in list
+
+    virtual void SanityCheck() const;	
+				// has this list been corrupted?
+    void SelfTest(T **p, int numEntries);
+				// verify module is working
+
+  protected:
+    T *first;  			// Head of the list, NULL if list is empty
+    T *last;			// Last element of list
+    int numInList;		// number of elements in list
+
+    static ListLink<T> *LinkOf(T *item) { return &(item->*Link); }
+				// where "item" keeps its links
+
+friend class IntrusiveListIterator<T, Link>;
+};
+
+// The following class defines an intrusive "sorted list", arranged
+// so that RemoveFront always returns the smallest item.  As with
+// SortedList, "compare" returns -1, 0 or 1 when x is less than,
+// equal to or greater than y.
+
+template <class T, ListLink<T> T::*Link>
+class IntrusiveSortedList : public IntrusiveList<T, Link> {
+  public:
+    IntrusiveSortedList(int (*comp)(T *x, T *y)) 
+	: IntrusiveList<T, Link>() { compare = comp;};
+    ~IntrusiveSortedList() {};	// base class destructor called automatically
+
+    void Insert(T *item); 	// insert an item onto the list in sorted order
+
+    void SanityCheck() const;	// has this list been corrupted?
+    void SelfTest(T **p, int numEntries);
+				// verify module is working
+
+  private:
+    int (*compare)(T *x, T *y);	// function for sorting list elements
+
+    void Prepend(T *item) { Insert(item); }  // *pre*pending has no meaning 
+				             //	in a sorted list
+    void Append(T *item) { Insert(item); }   // neither does *ap*pend 
+};
+
+// The following class can be used to step through an intrusive list,
+// in the same way as a ListIterator.
+
+template <class T, ListLink<T> T::*Link>
+class IntrusiveListIterator {
+  public:
+    IntrusiveListIterator(IntrusiveList<T, Link> *list) 
+	{ current = list->first; } 
+				// initialize an iterator
+
+    bool IsDone() { return current == NULL; };
+				// return TRUE if we are at the end of the list
+
+    T *Item() { ASSERT(!IsDone()); return current; };
+				// return current element on list
+
+    void Next() { current = (current->*Link).next; };		
+				// update iterator to point to next
+
+  private:
+    T *current;			// where we are in the list
+};
+
 #include "list.cc"		// templates are really like macros
 				// so needs to be included in every
 				// file that uses the template
@@ -32,10 +32,14 @@
 #include "sys/file.h"
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/mman.h>
 
 #ifdef LINUX	 // at this point, linux doesn't support mprotect 
 #define NO_MPROT     
 #endif
+#ifndef MAP_NORESERVE	// not every host can leave memory uncommitted
+#define MAP_NORESERVE 0
+#endif
 #ifdef DOS	// neither does DOS
 #define NO_MPROT
 #endif
@@ -205,6 +209,148 @@ DeallocBoundedArray(char *ptr, int size)
 #endif
 }
 
+//----------------------------------------------------------------------
+// AllocExecutableMemory
+// 	Return a region of memory that can be both written and executed,
+//	for simulators that translate user code into host instructions.
+//	Returns NULL if the host refuses.
+//
+//	"size" -- amount of space needed (in bytes)
+//----------------------------------------------------------------------
+
+char *
+AllocExecutableMemory(int size)
+{
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE | PROT_EXEC,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (ptr == MAP_FAILED) {
+	return NULL;
+    }
+    return (char *) ptr;
+}
+
+//----------------------------------------------------------------------
+// DeallocExecutableMemory
+// 	Give back memory returned by AllocExecutableMemory.
+//
+//	"ptr" -- the region to be deallocated
+//	"size" -- its size (in bytes)
+//----------------------------------------------------------------------
+
+void
+DeallocExecutableMemory(char *ptr, int size)
+{
+    munmap(ptr, size);
+}
+
+//----------------------------------------------------------------------
+// AllocStack
+// 	Return space for a thread stack, with the page just before and
+//	the page just after it unmapped, to catch a stack overflow.  Only
+//	address space is reserved: the host commits memory to a page of
+//	the stack when it is first touched, so a thread that never goes
+//	deep into its stack doesn't cost much, however big the stack.
+//
+//	"size" -- amount of useful space needed (in bytes); rounded up to
+//	whole pages
+//----------------------------------------------------------------------
+
+char *
+AllocStack(int size)
+{
+    int pgSize = getpagesize();
+    int length = divRoundUp(size, pgSize) * pgSize;
+    char *ptr = (char *) mmap(NULL, pgSize + length + pgSize, PROT_NONE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    int retVal;
+
+    ASSERT(ptr != (char *) MAP_FAILED);
+    retVal = mprotect(ptr + pgSize, length, PROT_READ | PROT_WRITE);
+    ASSERT(retVal == 0);
+    return ptr + pgSize;
+}
+
+//----------------------------------------------------------------------
+// DeallocStack
+// 	Give back a stack returned by AllocStack, guard pages and all.
+//
+//	"ptr" -- the stack to be deallocated
+//	"size" -- amount of useful space in it (in bytes)
+//----------------------------------------------------------------------
+
+void
+DeallocStack(char *ptr, int size)
+{
+    int pgSize = getpagesize();
+
+    munmap(ptr - pgSize, pgSize + divRoundUp(size, pgSize) * pgSize + pgSize);
+}
+
+//----------------------------------------------------------------------
+// StackCommitted
+// 	Return how much host memory has been committed to a stack
+//	returned by AllocStack: the pages of it that have been touched.
+//
+//	"ptr" -- the stack
+//	"size" -- amount of useful space in it (in bytes)
+//----------------------------------------------------------------------
+
+int
+StackCommitted(char *ptr, int size)
+{
+    int pgSize = getpagesize();
+    int numPages = divRoundUp(size, pgSize);
+    unsigned char inCore[64];
+    int committed = 0;
+
+    for (int i = 0; i < numPages; i += 64) {
+	int n = min(numPages - i, 64);
+
+	if (mincore(ptr + i * pgSize, n * pgSize, inCore) != 0)
+	    return size;		// can't tell: assume the worst
+	for (int j = 0; j < n; j++)
+	    if (inCore[j] & 1)
+		committed += pgSize;
+    }
+    return committed;
+}
+
+//----------------------------------------------------------------------
+// DecommitStack
+// 	Let the host take back the memory committed to a stack returned
+//	by AllocStack, but keep the stack: its pages read as zeroes, and
+//	are committed again when they are next touched.  The first and
+//	last pages are kept as they are, since every thread touches them.
+//
+//	"ptr" -- the stack
+//	"size" -- amount of useful space in it (in bytes)
+//----------------------------------------------------------------------
+
+void
+DecommitStack(char *ptr, int size)
+{
+    int pgSize = getpagesize();
+    int numPages = divRoundUp(size, pgSize);
+
+    if (numPages > 2)
+	madvise(ptr + pgSize, (numPages - 2) * pgSize, MADV_DONTNEED);
+}
+
+//----------------------------------------------------------------------
+// HostTime
+// 	Return the host's wall clock time, in seconds.
+//----------------------------------------------------------------------
+
+double
+HostTime()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
 //----------------------------------------------------------------------
 // PollFile
 // 	Check open file or open socket to see if there are any 
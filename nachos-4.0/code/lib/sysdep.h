@@ -35,6 +35,23 @@ extern unsigned int RandomNumber();
 extern char *AllocBoundedArray(int size);
 extern void DeallocBoundedArray(char *p, int size);
 
+// Allocate, de-allocate a thread stack, with a guard page at each end.
+// Host memory is only committed for the parts that are touched; report
+// how much has been, so far.
+extern char *AllocStack(int size);
+extern void DeallocStack(char *p, int size);
+extern int StackCommitted(char *p, int size);
+extern void DecommitStack(char *p, int size);
+
+// Allocate, de-allocate memory that host code can be generated into
+// and then executed.  Returns NULL if the host doesn't allow this.
+extern char *AllocExecutableMemory(int size);
+extern void DeallocExecutableMemory(char *p, int size);
+
+// Real (wall clock) time on the host, in seconds since some fixed
+// point in the past.  Only useful for measuring the simulator itself.
+extern double HostTime();
+
 // Check file to see if there are any characters to be read.
 // If no characters in the file, return without waiting.
 extern bool PollFile(int fd);
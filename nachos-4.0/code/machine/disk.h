@@ -20,6 +20,9 @@
 #include "copyright.h"
 #include "utility.h"
 #include "callback.h"
+#include "stats.h"
+
+class PendingInterrupt;
 
 // The following class defines a physical disk I/O device.  The disk
 // has a single surface, split up into "tracks", and each track split
@@ -78,13 +81,14 @@ class Disk : public CallBackObj {
   private:
     int fileno;				// UNIX file number for simulated disk 
     CallBackObj *callWhenDone;		// Invoke when any disk request finishes
-    bool active;     			// Is a disk operation in progress?
+    PendingInterrupt *request;		// The interrupt that will end the
+					// disk operation in progress, if any
     int lastSector;			// The previous disk request 
-    int bufferInit;			// When the track buffer started 
+    Ticks bufferInit;			// When the track buffer started 
 					// being loaded
 
     int TimeToSeek(int newSector, int *rotate); // time to get to the new track
-    int ModuloDiff(int to, int from);        // # sectors between to and from
+    int ModuloDiff(int to, Ticks from);      // # sectors between to and from
     void UpdateLast(int newSector);
 };
 
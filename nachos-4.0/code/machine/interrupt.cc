@@ -42,11 +42,40 @@ static char *intTypeNames[] = { "timer", "disk", "console write",
 //----------------------------------------------------------------------
 
 PendingInterrupt::PendingInterrupt(CallBackObj *callOnInt, 
-					int time, IntType kind)
+					Ticks time, IntType kind)
 {
     callOnInterrupt = callOnInt;
     when = time;
     type = kind;
+    heapIndex = -1;
+}
+
+//----------------------------------------------------------------------
+// PendingInterrupt::Cancel
+// 	Call off an interrupt that has been scheduled, but has not yet
+//	occurred.  The handle must not be used after this.
+//----------------------------------------------------------------------
+
+void
+PendingInterrupt::Cancel()
+{
+    kernel->interrupt->Cancel(this);
+}
+
+//----------------------------------------------------------------------
+// PendingInterrupt::Reschedule
+// 	Change when an interrupt that has not yet occurred is to occur.
+//	Among interrupts due at the same time, it then counts as the
+//	last one scheduled.
+//
+//	"newWhen" -- when (in simulated time) it is now to occur; must
+//		be in the future
+//----------------------------------------------------------------------
+
+void
+PendingInterrupt::Reschedule(Ticks newWhen)
+{
+    kernel->interrupt->Reschedule(this, newWhen);
 }
 
 //----------------------------------------------------------------------
@@ -59,9 +88,23 @@ PendingCompare (PendingInterrupt *x, PendingInterrupt *y)
 {
     if (x->when < y->when) { return -1; }
     else if (x->when > y->when) { return 1; }
+    else if (x->order < y->order) { return -1; }
+    else if (x->order > y->order) { return 1; }
     else { return 0; }
 }
 
+//----------------------------------------------------------------------
+// PendingPlace
+//	Note where an interrupt is on the pending heap, so it can be
+//	found again to be cancelled or rescheduled.
+//----------------------------------------------------------------------
+
+static void
+PendingPlace (PendingInterrupt *x, int i)
+{
+    x->heapIndex = i;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::Interrupt
 // 	Initialize the simulation of hardware device interrupts.
@@ -72,7 +115,9 @@ PendingCompare (PendingInterrupt *x, PendingInterrupt *y)
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new SortedList<PendingInterrupt *>(PendingCompare);
+    pending = new Heap<PendingInterrupt *>(PendingCompare, PendingPlace);
+    numScheduled = 0;
+    freeList = NULL;
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
@@ -89,6 +134,11 @@ Interrupt::~Interrupt()
 	delete pending->RemoveFront();
     }
     delete pending;
+    while (freeList != NULL) {
+	PendingInterrupt *next = freeList->nextFree;
+	delete freeList;
+	freeList = next;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -175,6 +225,76 @@ Interrupt::OneTick()
     }
 }
 
+//----------------------------------------------------------------------
+// Interrupt::AdvanceUserTime
+// 	Advance simulated time over a run of user instructions, all in one
+//	step.  Used by simulators that execute several instructions before
+//	coming back to OneTick; the caller must make sure that no pending
+//	interrupt became due part way through (see TicksUntilNextInterrupt).
+//
+//	"numInstrs" -- how many user instructions were executed
+//----------------------------------------------------------------------
+
+void
+Interrupt::AdvanceUserTime(int numInstrs)
+{
+    Statistics *stats = kernel->stats;
+
+    ASSERT(status == UserMode);
+    stats->totalTicks += numInstrs * UserTick;
+    stats->userTicks += numInstrs * UserTick;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::OnlyTimerPending
+// 	Return TRUE if no interrupt is scheduled, other than the timer's.
+//	(The timer turns itself off when there is nothing left to do.)
+//----------------------------------------------------------------------
+
+bool
+Interrupt::OnlyTimerPending()
+{
+    return pending->IsEmpty() ||
+	(pending->NumInHeap() == 1 && pending->Front()->type == TimerInt);
+}
+
+//----------------------------------------------------------------------
+// Interrupt::SetClock
+// 	Move simulated time to "now", when resuming from a snapshot of a
+//	run that had reached that time.  Only the timer can be pending;
+//	it is made due at "timerWhen", as it was in the snapshot, or
+//	taken off the list for good if it had been turned off by then
+//	("timerWhen" negative).
+//----------------------------------------------------------------------
+
+void
+Interrupt::SetClock(Ticks now, Ticks timerWhen)
+{
+    ASSERT(pending->NumInHeap() == 1 && pending->Front()->type == TimerInt);
+    kernel->stats->totalTicks = now;
+    if (timerWhen < 0) {
+	Cancel(pending->Front());
+    } else {
+	Reschedule(pending->Front(), timerWhen);
+    }
+}
+
+//----------------------------------------------------------------------
+// Interrupt::TicksUntilNextInterrupt
+// 	Return how far in the future the earliest pending interrupt is.
+//	If nothing is pending, return a value larger than any run of
+//	instructions will reach.
+//----------------------------------------------------------------------
+
+Ticks
+Interrupt::TicksUntilNextInterrupt()
+{
+    if (pending->IsEmpty()) {
+	return 0x7fffffff;
+    }
+    return pending->Front()->when - kernel->stats->totalTicks;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::YieldOnReturn
 // 	Called from within an interrupt handler, to cause a context switch
@@ -193,6 +313,21 @@ Interrupt::YieldOnReturn()
     yieldOnReturn = TRUE; 
 }
 
+//----------------------------------------------------------------------
+// Interrupt::YieldWhenEnabled
+// 	Like YieldOnReturn, but may also be called from kernel code
+//	running with interrupts disabled (for example, when a thread is
+//	woken up by Semaphore::V): the context switch happens as soon
+//	as interrupts are enabled again, or in a handler, when it returns.
+//----------------------------------------------------------------------
+
+void
+Interrupt::YieldWhenEnabled()
+{ 
+    ASSERT(level == IntOff);  
+    yieldOnReturn = TRUE; 
+}
+
 //----------------------------------------------------------------------
 // Interrupt::Idle
 // 	Routine called when there is nothing in the ready queue.
@@ -234,6 +369,7 @@ void
 Interrupt::Halt()
 {
     cout << "Machine halting!\n\n";
+    Thread::SampleStacks();
     kernel->stats->Print();
     delete kernel;	// Never returns.
 }
@@ -243,7 +379,7 @@ Interrupt::Halt()
 // 	Arrange for the CPU to be interrupted when simulated time
 //	reaches "now + when".
 //
-//	Implementation: just put it on a sorted list.
+//	Implementation: put it on a heap, soonest first.
 //
 //	NOTE: the Nachos kernel should not call this routine directly.
 //	Instead, it is only called by the hardware device simulators.
@@ -252,17 +388,71 @@ Interrupt::Halt()
 //	"fromNow" is how far in the future (in simulated time) the 
 //		 interrupt is to occur
 //	"type" is the hardware device that generated the interrupt
+//
+// Returns:
+//	A handle on the interrupt, good until it occurs or is cancelled.
 //----------------------------------------------------------------------
-void
-Interrupt::Schedule(CallBackObj *toCall, int fromNow, IntType type)
+PendingInterrupt *
+Interrupt::Schedule(CallBackObj *toCall, Ticks fromNow, IntType type)
 {
-    int when = kernel->stats->totalTicks + fromNow;
-    PendingInterrupt *toOccur = new PendingInterrupt(toCall, when, type);
+    Ticks when = kernel->stats->totalTicks + fromNow;
+    PendingInterrupt *toOccur;
 
     DEBUG(dbgInt, "Scheduling interrupt handler the " << intTypeNames[type] << " at time = " << when);
     ASSERT(fromNow > 0);
 
+    if (freeList != NULL) {		// re-use one that has fired
+	toOccur = freeList;
+	freeList = toOccur->nextFree;
+	toOccur->callOnInterrupt = toCall;
+	toOccur->when = when;
+	toOccur->type = type;
+    } else {
+	toOccur = new PendingInterrupt(toCall, when, type);
+    }
+    toOccur->order = numScheduled++;
     pending->Insert(toOccur);
+    return toOccur;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Cancel
+// 	Take an interrupt that has not occurred yet off the pending heap,
+//	and keep it for Schedule to re-use.
+//
+//	"toCancel" -- the interrupt, as returned by Schedule
+//----------------------------------------------------------------------
+
+void
+Interrupt::Cancel(PendingInterrupt *toCancel)
+{
+    DEBUG(dbgInt, "Cancelling interrupt handler the " << intTypeNames[toCancel->type] << " at time = " << toCancel->when);
+    ASSERT(toCancel->heapIndex >= 0);	// it must not have occurred yet
+
+    (void) pending->Remove(toCancel->heapIndex);
+    toCancel->nextFree = freeList;
+    freeList = toCancel;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Reschedule
+// 	Move an interrupt that has not occurred yet to a new time, and
+//	to its new place on the pending heap.
+//
+//	"toMove" -- the interrupt, as returned by Schedule
+//	"when" -- the time it is now to occur at
+//----------------------------------------------------------------------
+
+void
+Interrupt::Reschedule(PendingInterrupt *toMove, Ticks when)
+{
+    DEBUG(dbgInt, "Rescheduling interrupt handler the " << intTypeNames[toMove->type] << " at time = " << when);
+    ASSERT(toMove->heapIndex >= 0);	// it must not have occurred yet
+    ASSERT(when > kernel->stats->totalTicks);
+
+    toMove->when = when;
+    toMove->order = numScheduled++;
+    pending->Changed(toMove->heapIndex);
 }
 
 //----------------------------------------------------------------------
@@ -313,7 +503,8 @@ Interrupt::CheckIfDue(bool advanceClock)
     do {
         next = pending->RemoveFront();    // pull interrupt off list
         next->callOnInterrupt->CallBack();// call the interrupt handler
-	delete next;
+	next->nextFree = freeList;	// keep it, for Schedule to re-use
+	freeList = next;
     } while (!pending->IsEmpty() 
     		&& (pending->Front()->when <= stats->totalTicks));
     inHandler = FALSE;
@@ -345,6 +536,16 @@ Interrupt::DumpState()
     cout << "Time: " << kernel->stats->totalTicks;
     cout << ", interrupts " << intLevelNames[level] << "\n";
     cout << "Pending interrupts:\n";
-    pending->Apply(PrintPending);
+    // take them all off the heap, to print them in the order they
+    // will fire, then put them back
+    int numPending = pending->NumInHeap();
+    PendingInterrupt **inOrder = new PendingInterrupt *[numPending];
+    for (int i = 0; i < numPending; i++) {
+	inOrder[i] = pending->RemoveFront();
+	PrintPending(inOrder[i]);
+    }
+    for (int i = 0; i < numPending; i++)
+	pending->Insert(inOrder[i]);
+    delete [] inOrder;
     cout << "\nEnd of pending interrupts\n";
 }
@@ -36,8 +36,9 @@
 #define INTERRUPT_H
 
 #include "copyright.h"
-#include "list.h"
+#include "heap.h"
 #include "callback.h"
+#include "stats.h"
 
 // Interrupts can be disabled (IntOff) or enabled (IntOn)
 enum IntStatus { IntOff, IntOn };
@@ -56,18 +57,34 @@ enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt,
 // The following class defines an interrupt that is scheduled
 // to occur in the future.  The internal data structures are
 // left public to make it simpler to manipulate.
+//
+// Interrupt::Schedule returns one of these, which the hardware device
+// simulator can keep, to call off the interrupt or change when it is
+// to occur.  It is only good until the interrupt occurs or is called
+// off; after that, Schedule re-uses it for other interrupts.
 
 class PendingInterrupt {
   public:
-    PendingInterrupt(CallBackObj *callOnInt, int time, IntType kind);
+    PendingInterrupt(CallBackObj *callOnInt, Ticks time, IntType kind);
 				// initialize an interrupt that will
 				// occur in the future
 
+    void Cancel();		// the interrupt is not to occur after all
+    void Reschedule(Ticks newWhen);
+				// make it occur at time "newWhen" instead
+
     CallBackObj *callOnInterrupt;// The object (in the hardware device
 				// emulator) to call when the interrupt occurs
     
-    int when;			// When the interrupt is supposed to fire
+    Ticks when;			// When the interrupt is supposed to fire
     IntType type;		// for debugging
+    unsigned long long order;	// When it was scheduled, relative to the
+				// others: interrupts due at the same time
+				// fire in the order they were scheduled
+    int heapIndex;		// Where it is on the pending heap; -1
+				// if it isn't scheduled
+    PendingInterrupt *nextFree;	// Next one on the free list, once it
+				// has fired
 };
 
 // The following class defines the data structures for the simulation
@@ -98,6 +115,8 @@ class Interrupt {
     
     void YieldOnReturn();	// cause a context switch on return 
 				// from an interrupt handler
+    void YieldWhenEnabled();	// or, from kernel code, as soon as
+				// interrupts are enabled again
 
     MachineStatus getStatus() { return status; } 
     void setStatus(MachineStatus st) { status = st; }
@@ -105,6 +124,13 @@ class Interrupt {
 
     bool AnyFutureInterrupts() { return !pending->IsEmpty(); }
     				// are any interrupts scheduled?
+    bool OnlyTimerPending();	// is nothing but the timer scheduled?
+
+    void SetClock(Ticks now, Ticks timerWhen);
+				// Set the simulated time to "now", and
+				// make the timer due at "timerWhen" (or
+				// turn it off, if negative) -- to restart
+				// from a snapshot
 
     void DumpState();		// Print interrupt state
     
@@ -114,18 +140,31 @@ class Interrupt {
     // but they need to be public since they are called by the
     // hardware device simulators.
 
-    void Schedule(CallBackObj *callTo, int when, IntType type);
+    PendingInterrupt *Schedule(CallBackObj *callTo, Ticks when, IntType type);
     				// Schedule an interrupt to occur
 				// at time "when".  This is called
     				// by the hardware device simulators.
+				// Returns a handle on the interrupt.
     
     void OneTick();       	// Advance simulated time
 
+    void AdvanceUserTime(int numInstrs);
+				// Charge the time of "numInstrs" user
+				// instructions at once, without checking
+				// for interrupts.  Only legal if none can
+				// have become due in that time.
+
+    Ticks TicksUntilNextInterrupt();
+				// How long (in simulated time) until the
+				// next scheduled interrupt is due?
+
   private:
     IntStatus level;		// are interrupts enabled or disabled?
-    SortedList<PendingInterrupt *> *pending;		
-    				// the list of interrupts scheduled
-				// to occur in the future
+    Heap<PendingInterrupt *> *pending;
+    				// the interrupts scheduled to occur
+				// in the future, soonest first
+    unsigned long long numScheduled; // how many have been scheduled so far
+    PendingInterrupt *freeList;	// ones that have fired, to be re-used
     bool inHandler;		// TRUE if we are running an interrupt handler
     bool yieldOnReturn; 	// TRUE if we are to context switch
 				// on return from the interrupt handler
@@ -139,6 +178,14 @@ class Interrupt {
 
     void ChangeLevel(IntStatus old, 	// SetLevel, without advancing the
 			IntStatus now); // simulated time
+
+    void Cancel(PendingInterrupt *toCancel);
+				// Take an interrupt off the pending
+				// heap, for re-use
+    void Reschedule(PendingInterrupt *toMove, Ticks when);
+				// Move it to time "when" on the heap
+
+    friend class PendingInterrupt;
 };
 
 #endif // INTERRRUPT_H
@@ -0,0 +1,1028 @@
+// jit.cc
+//	Routines to translate hot blocks of MIPS user code into native
+//	x86-64 code, and to keep the translations up to date with
+//	physical memory.  See jit.h for the overall scheme.
+//
+//	While a block runs, the host registers are used as follows:
+//		rbx -- the simulated machine's register array
+//		r12 -- the target of the block's branch, once known
+//		r13 -- the Machine object, for calls back into C++
+//		eax, ecx, edx, esi, r8 -- scratch, and arguments
+//	and the word at the top of the host stack receives loaded values,
+//	the one above it the status of the last memory access.
+//
+//	The simulated PC registers are only written when the block exits;
+//	everything else is kept in "registers" after every instruction,
+//	just as the interpreter does.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "jit.h"
+#include "machine.h"
+#include "mipssim.h"
+#include "main.h"
+
+// Host registers, by their x86 encoding
+#define EAX	0
+#define ECX	1
+#define EDX	2
+#define ESI	6
+
+// Opcodes of "op eax, [rbx + disp]"
+#define ADD_LOAD	0x03
+#define OR_LOAD		0x0b
+#define AND_LOAD	0x23
+#define SUB_LOAD	0x2b
+#define XOR_LOAD	0x33
+#define CMP_LOAD	0x3b
+
+// Values of pendingLoad, besides a register number
+#define NoLoad		-1
+#define UnknownLoad	-2
+
+// Enough room for the host code of any one block
+static const int MaxBlockBytes = MaxBlockLength * 160 + 256;
+
+//----------------------------------------------------------------------
+// BinaryTranslator::BinaryTranslator
+// 	Initialize an empty code cache, for the code in "m"'s memory.
+//----------------------------------------------------------------------
+
+BinaryTranslator::BinaryTranslator(Machine *m)
+{
+    int numWords = MemorySize() / 4;
+
+    machine = m;
+    numRunning = 0;
+    charged = 0;
+    yielded = FALSE;
+    blocks = new TranslatedBlock *[numWords];
+    translated = new bool[numWords];
+    counts = new unsigned char[numWords];
+    numBlocks = new int[NumPhysPages];
+    cache = (unsigned char *) AllocExecutableMemory(CodeCacheSize);
+    ASSERT(cache != NULL);
+    for (int i = 0; i < numWords; i++) {
+	counts[i] = 0;
+    }
+    Flush();
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::~BinaryTranslator
+// 	De-allocate the code cache and the tables that lead into it.
+//----------------------------------------------------------------------
+
+BinaryTranslator::~BinaryTranslator()
+{
+    DeallocExecutableMemory((char *) cache, CodeCacheSize);
+    delete [] blocks;
+    delete [] translated;
+    delete [] counts;
+    delete [] numBlocks;
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::Flush
+// 	Throw away every translation, and start filling the code cache
+//	again from the beginning.  Not while any block is running: its
+//	host code would be overwritten.
+//----------------------------------------------------------------------
+
+void
+BinaryTranslator::Flush()
+{
+    ASSERT(numRunning == 0);
+    for (int i = 0; i < MemorySize() / 4; i++) {
+	blocks[i] = NULL;
+	translated[i] = FALSE;
+    }
+    for (unsigned int i = 0; i < NumPhysPages; i++) {
+	numBlocks[i] = 0;
+    }
+    next = cache;
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::InvalidatePage
+// 	Forget the translations of the code in one physical page.  The
+//	host code itself stays in the cache until it is flushed.
+//
+//	"pageFrame" -- the physical page number
+//----------------------------------------------------------------------
+
+void
+BinaryTranslator::InvalidatePage(unsigned int pageFrame)
+{
+    ASSERT(pageFrame < NumPhysPages);
+    if (numBlocks[pageFrame] == 0) {
+	return;
+    }
+    for (unsigned int i = 0; i < PageSize / 4; i++) {
+	blocks[pageFrame * (PageSize / 4) + i] = NULL;
+	translated[pageFrame * (PageSize / 4) + i] = FALSE;
+    }
+    numBlocks[pageFrame] = 0;
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::Lookup
+// 	Find the translation of the block that starts at "physAddr", when
+//	the user program reaches it at "virtAddr".  Blocks are translated
+//	once they have started HotThreshold times; until then, count this
+//	time and let the caller interpret the block.  The caller also
+//	interprets it if the code cache is full, but can't be flushed yet.
+//
+//	"physAddr" -- physical address of the first instruction
+//	"virtAddr" -- the same, as a user virtual address
+//----------------------------------------------------------------------
+
+TranslatedBlock *
+BinaryTranslator::Lookup(int physAddr, int virtAddr)
+{
+    int word = physAddr / 4;
+    TranslatedBlock *block = blocks[word];
+
+    if (block != NULL && block->virtAddr == virtAddr) {
+	return block;
+    }
+    if (++counts[word] < HotThreshold) {
+	return NULL;
+    }
+    counts[word] = 0;
+    return Translate(physAddr, virtAddr);
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::Run
+// 	Run the host code of a block, for the current thread.  Returns
+//	the number of instructions run, as the code does.
+//
+//	"block" -- the block, of at least one instruction
+//	"charged" -- where to put how many of those were already charged
+//		to the clock, before a load or store
+//	"yielded" -- where to put whether another thread ran meanwhile,
+//		so that the block stopped early
+//----------------------------------------------------------------------
+
+int
+BinaryTranslator::Run(TranslatedBlock *block, int *charged, bool *yielded)
+{
+    int numInstrs;
+
+    numRunning++;		// no flushing until it finishes
+    this->charged = 0;
+    this->yielded = FALSE;
+    numInstrs = (*block->code)(machine, machine->registers);
+    numRunning--;
+    *charged = this->charged;
+    *yielded = this->yielded;
+    return numInstrs;
+}
+
+//----------------------------------------------------------------------
+// IsBranch
+// 	Does "instr" change the flow of control, after its delay slot?
+//----------------------------------------------------------------------
+
+static bool
+IsBranch(Instruction *instr)
+{
+    switch (instr->opCode) {
+      case OP_BEQ: case OP_BGEZ: case OP_BGEZAL: case OP_BGTZ:
+      case OP_BLEZ: case OP_BLTZ: case OP_BLTZAL: case OP_BNE:
+      case OP_J: case OP_JAL: case OP_JALR: case OP_JR:
+	return TRUE;
+      default:
+	return FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::BlockLength
+// 	Decide where the block starting at "physAddr" ends: after the
+//	delay slot of the first branch or jump, before the first
+//	instruction we can't translate, at the end of the page, or after
+//	MaxBlockLength instructions, whichever comes first.
+//
+//	Returns the number of instructions in the block, and sets
+//	"*lastMemOp" to the index of its last load or store (-1 if none).
+//----------------------------------------------------------------------
+
+int
+BinaryTranslator::BlockLength(int physAddr, int *lastMemOp)
+{
+    int pageEnd = (physAddr / PageSize + 1) * PageSize;
+    bool delaySlot = FALSE;
+    int i;
+
+    *lastMemOp = -1;
+    for (i = 0; i < MaxBlockLength && physAddr + 4 * i < pageEnd; i++) {
+	Instruction *instr = machine->FetchDecoded(physAddr + 4 * i);
+
+	if (IsBranch(instr)) {
+	    if (delaySlot) {
+		return i;		// a branch in a delay slot: leave
+					// that to the interpreter
+	    }
+	    delaySlot = TRUE;
+	    continue;
+	}
+	switch (instr->opCode) {
+	  case OP_LB: case OP_LBU: case OP_LH: case OP_LHU: case OP_LW:
+	  case OP_SB: case OP_SH: case OP_SW:
+	    *lastMemOp = i;
+	    break;
+
+	  case OP_LWL: case OP_LWR: case OP_SWL: case OP_SWR:
+	  case OP_SYSCALL: case OP_RES: case OP_UNIMP: case OP_RFE:
+	    return i;
+
+	  default:
+	    break;
+	}
+	if (delaySlot) {
+	    return i + 1;
+	}
+    }
+    return i;
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::Translate
+// 	Generate the host code for the block starting at "physAddr".
+//	Returns NULL if there's no room for it.
+//
+//	"physAddr" -- physical address of the first instruction
+//	"virtAddr" -- the same, as a user virtual address
+//----------------------------------------------------------------------
+
+TranslatedBlock *
+BinaryTranslator::Translate(int physAddr, int virtAddr)
+{
+    TranslatedBlock *block;
+    bool delaySlot[MaxBlockLength];
+    int length, lastMemOp, touchAt;
+    unsigned char *bailStub = NULL;
+
+    if (next + MaxBlockBytes > cache + CodeCacheSize) {
+	if (numRunning > 0) {
+	    return NULL;	// a thread is part way through a block
+	}
+	Flush();
+    }
+    next = (unsigned char *) (((unsigned long) next + 15) & ~15UL);
+    block = (TranslatedBlock *) next;
+    next += sizeof(TranslatedBlock);
+    next = (unsigned char *) (((unsigned long) next + 15) & ~15UL);
+
+    block->virtAddr = virtAddr;
+    block->length = length = BlockLength(physAddr, &lastMemOp);
+    block->code = (BlockCode) next;
+    blocks[physAddr / 4] = block;
+    numBlocks[physAddr / PageSize]++;
+    kernel->stats->numTranslatedBlocks++;
+    DEBUG(dbgMach, "Translated " << length << " instructions at "
+				<< virtAddr);
+    if (length == 0) {
+	return block;
+    }
+
+    // prologue: save what we use of the callee-saved registers, and
+    // leave the stack aligned for calls
+    EmitByte(0x53);				// push rbx
+    EmitByte(0x41); EmitByte(0x54);		// push r12
+    EmitByte(0x41); EmitByte(0x55);		// push r13
+    EmitByte(0x48); EmitByte(0x83); EmitByte(0xec); EmitByte(0x10);
+						// sub rsp, 16
+    EmitByte(0x49); EmitByte(0x89); EmitByte(0xfd);	// mov r13, rdi
+    EmitByte(0x48); EmitByte(0x89); EmitByte(0xf3);	// mov rbx, rsi
+
+    // The interpreter looks up the code page again for the fetch after
+    // every load or store, which moves it to the end of the LRU order.
+    // Only the last time matters: the fetch just after the last load
+    // or store, or if that is the last instruction, just before it.
+    if (lastMemOp >= 0 && lastMemOp < length - 1) {
+	touchAt = lastMemOp + 1;
+    } else if (lastMemOp == length - 1) {
+	touchAt = lastMemOp;
+    } else {
+	touchAt = -1;
+    }
+
+    pendingLoad = UnknownLoad;
+    numBails = 0;
+    for (int i = 0; i < length; i++) {
+	Instruction *instr = machine->FetchDecoded(physAddr + 4 * i);
+
+	translated[physAddr / 4 + i] = TRUE;
+
+	delaySlot[i] = (i > 0) &&
+		IsBranch(machine->FetchDecoded(physAddr + 4 * (i - 1)));
+	EmitInstruction(instr, virtAddr + 4 * i, i, delaySlot[i],
+			i == touchAt, i == length - 1);
+    }
+    EmitExit(length, virtAddr + 4 * (length - 1), delaySlot[length - 1],
+	     IsBranch(machine->FetchDecoded(physAddr + 4 * (length - 1))));
+
+    // one way out for each instruction some jump stops just before
+    for (int i = 0; i < length; i++) {
+	bool emitted = FALSE;
+
+	for (int j = 0; j < numBails; j++) {
+	    if (bailTo[j] == i) {
+		if (!emitted) {
+		    bailStub = next;
+		    EmitBail(i, virtAddr + 4 * i, delaySlot[i]);
+		    emitted = TRUE;
+		}
+		*(int *) bailFrom[j] = bailStub - (bailFrom[j] + 4);
+	    }
+	}
+    }
+    ASSERT(next <= cache + CodeCacheSize);
+    return block;
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::EmitInstruction
+// 	Generate the host code for one user instruction: its effect on
+//	the registers, followed by any delayed load it completes.
+//
+//	"instr" -- the decoded instruction
+//	"virtAddr" -- the user virtual address it is at
+//	"index" -- its position in the block
+//	"delaySlot" -- is it in the delay slot of a branch?
+//	"touchCode" -- must the code page be marked as used before any
+//		load or store this instruction does?
+//	"last" -- is it the last instruction in the block?
+//----------------------------------------------------------------------
+
+void
+BinaryTranslator::EmitInstruction(Instruction *instr, int virtAddr,
+				  int index, bool delaySlot, bool touchCode,
+				  bool last)
+{
+    int rs = instr->rs, rt = instr->rt, rd = instr->rd;
+    int extra = instr->extra;
+    int size = 0;
+    bool isLoad = FALSE;
+    int cmov = 0;		// condition code of a conditional branch
+
+    if (touchCode) {
+	EmitByte(0x4c); EmitByte(0x89); EmitByte(0xef);	// mov rdi, r13
+	EmitByte(0xbe); EmitWord(virtAddr);		// mov esi, virtAddr
+	EmitByte(0xba); EmitWord(index);		// mov edx, index
+	EmitCall((void *) TouchCode);
+	EmitAccessCheck(index);
+    }
+
+    switch (instr->opCode) {
+      case OP_ADD:
+      case OP_SUB:
+	EmitLoadReg(EAX, rs);
+	EmitArith(instr->opCode == OP_ADD ? ADD_LOAD : SUB_LOAD, rt);
+	EmitJumpToBail(0x80, index);		// jo bail
+	if (rd != 0) {
+	    EmitStoreReg(rd, EAX);
+	}
+	break;
+
+      case OP_ADDI:
+	EmitLoadReg(EAX, rs);
+	EmitByte(0x05); EmitWord(extra);	// add eax, extra
+	EmitJumpToBail(0x80, index);		// jo bail
+	if (rt != 0) {
+	    EmitStoreReg(rt, EAX);
+	}
+	break;
+
+      case OP_ADDU:
+      case OP_AND:
+      case OP_NOR:
+      case OP_OR:
+      case OP_SUBU:
+      case OP_XOR:
+	if (rd == 0) {
+	    break;
+	}
+	EmitLoadReg(EAX, rs);
+	switch (instr->opCode) {
+	  case OP_ADDU:	EmitArith(ADD_LOAD, rt); break;
+	  case OP_AND:	EmitArith(AND_LOAD, rt); break;
+	  case OP_OR:	EmitArith(OR_LOAD, rt); break;
+	  case OP_SUBU:	EmitArith(SUB_LOAD, rt); break;
+	  case OP_XOR:	EmitArith(XOR_LOAD, rt); break;
+	  case OP_NOR:
+	    EmitArith(OR_LOAD, rt);
+	    EmitByte(0xf7); EmitByte(0xd0);	// not eax
+	    break;
+	}
+	EmitStoreReg(rd, EAX);
+	break;
+
+      case OP_ADDIU:
+      case OP_ANDI:
+      case OP_ORI:
+      case OP_XORI:
+	if (rt == 0) {
+	    break;
+	}
+	EmitLoadReg(EAX, rs);
+	switch (instr->opCode) {
+	  case OP_ADDIU: EmitByte(0x05); EmitWord(extra); break;
+	  case OP_ANDI:	 EmitByte(0x25); EmitWord(extra & 0xffff); break;
+	  case OP_ORI:	 EmitByte(0x0d); EmitWord(extra & 0xffff); break;
+	  case OP_XORI:	 EmitByte(0x35); EmitWord(extra & 0xffff); break;
+	}
+	EmitStoreReg(rt, EAX);
+	break;
+
+      case OP_LUI:
+	if (rt != 0) {
+	    EmitStoreImm(rt, extra << 16);
+	}
+	break;
+
+      case OP_SLT:
+      case OP_SLTU:
+      case OP_SLTI:
+      case OP_SLTIU:
+	if ((instr->opCode == OP_SLT || instr->opCode == OP_SLTU) ?
+		rd == 0 : rt == 0) {
+	    break;
+	}
+	EmitLoadReg(EAX, rs);
+	if (instr->opCode == OP_SLT || instr->opCode == OP_SLTU) {
+	    EmitArith(CMP_LOAD, rt);
+	} else {
+	    EmitByte(0x3d); EmitWord(extra);	// cmp eax, extra
+	}
+	EmitByte(0x0f);
+	if (instr->opCode == OP_SLT || instr->opCode == OP_SLTI) {
+	    EmitByte(0x9c);			// setl al
+	} else {
+	    EmitByte(0x92);			// setb al
+	}
+	EmitByte(0xc0);
+	EmitByte(0x0f); EmitByte(0xb6); EmitByte(0xc0);	// movzx eax, al
+	EmitStoreReg((instr->opCode == OP_SLT || instr->opCode == OP_SLTU) ?
+			rd : rt, EAX);
+	break;
+
+      case OP_SLL:
+      case OP_SRA:
+      case OP_SRL:
+	// the interpreter shifts right arithmetically for SRL too
+	if (rd == 0) {
+	    break;
+	}
+	EmitLoadReg(EAX, rt);
+	EmitByte(0xc1);
+	EmitByte(instr->opCode == OP_SLL ? 0xe0 : 0xf8);	// shl/sar eax,
+	EmitByte(extra);
+	EmitStoreReg(rd, EAX);
+	break;
+
+      case OP_SLLV:
+      case OP_SRAV:
+      case OP_SRLV:
+	if (rd == 0) {
+	    break;
+	}
+	EmitLoadReg(ECX, rs);
+	EmitLoadReg(EAX, rt);
+	EmitByte(0xd3);
+	EmitByte(instr->opCode == OP_SLLV ? 0xe0 : 0xf8);	// shl/sar eax, cl
+	EmitStoreReg(rd, EAX);
+	break;
+
+      case OP_MFHI:
+      case OP_MFLO:
+	if (rd != 0) {
+	    EmitLoadReg(EAX, instr->opCode == OP_MFHI ? HiReg : LoReg);
+	    EmitStoreReg(rd, EAX);
+	}
+	break;
+
+      case OP_MTHI:
+      case OP_MTLO:
+	EmitLoadReg(EAX, rs);
+	EmitStoreReg(instr->opCode == OP_MTHI ? HiReg : LoReg, EAX);
+	break;
+
+      case OP_MULT:
+      case OP_MULTU:
+	// a 64-bit product of the sign- or zero-extended operands is what
+	// the interpreter's shift-and-add gives
+	if (instr->opCode == OP_MULT) {
+	    EmitByte(0x48); EmitByte(0x63); EmitByte(0x83);
+	    EmitWord(rs * 4);			// movsxd rax, [rs]
+	    EmitByte(0x48); EmitByte(0x63); EmitByte(0x8b);
+	    EmitWord(rt * 4);			// movsxd rcx, [rt]
+	} else {
+	    EmitLoadReg(EAX, rs);
+	    EmitLoadReg(ECX, rt);
+	}
+	EmitByte(0x48); EmitByte(0x0f); EmitByte(0xaf); EmitByte(0xc1);
+						// imul rax, rcx
+	EmitStoreReg(LoReg, EAX);
+	EmitByte(0x48); EmitByte(0xc1); EmitByte(0xe8); EmitByte(32);
+						// shr rax, 32
+	EmitStoreReg(HiReg, EAX);
+	break;
+
+      case OP_DIV:
+      case OP_DIVU:
+	EmitByte(0x48); EmitByte(0x89); EmitByte(0xdf);	// mov rdi, rbx
+	EmitByte(0xbe); EmitWord(rs);			// mov esi, rs
+	EmitByte(0xba); EmitWord(rt);			// mov edx, rt
+	EmitByte(0xb9); EmitWord(instr->opCode);	// mov ecx, opCode
+	EmitCall((void *) Divide);
+	break;
+
+      case OP_BEQ:  cmov = 0x44; goto compare;		// cmove
+      case OP_BNE:  cmov = 0x45; goto compare;		// cmovne
+      case OP_BGEZ: cmov = 0x49; goto test;		// cmovns
+      case OP_BLTZ: cmov = 0x48; goto test;		// cmovs
+      case OP_BGTZ: cmov = 0x4f; goto test;		// cmovg
+      case OP_BLEZ: cmov = 0x4e; goto test;		// cmovle
+      case OP_BGEZAL: cmov = 0x49; goto link;
+      case OP_BLTZAL: cmov = 0x48; goto link;
+      link:
+	EmitStoreImm(R31, virtAddr + 8);
+      test:
+	EmitLoadReg(EAX, rs);
+	EmitByte(0x85); EmitByte(0xc0);		// test eax, eax
+	goto branch;
+      compare:
+	EmitLoadReg(EAX, rs);
+	EmitArith(CMP_LOAD, rt);
+      branch:
+	EmitByte(0x41); EmitByte(0xbc); EmitWord(virtAddr + 8);
+						// mov r12d, fall through
+	EmitByte(0xb9);
+	EmitWord(virtAddr + 4 + IndexToAddr(extra));	// mov ecx, target
+	EmitByte(0x44); EmitByte(0x0f); EmitByte(cmov); EmitByte(0xe1);
+						// cmovcc r12d, ecx
+	break;
+
+      case OP_JAL:
+	EmitStoreImm(R31, virtAddr + 8);
+      case OP_J:
+	EmitByte(0x41); EmitByte(0xbc);		// mov r12d, target
+	EmitWord(((virtAddr + 8) & 0xf0000000) | IndexToAddr(extra));
+	break;
+
+      case OP_JALR:
+	if (rd != 0) {
+	    EmitStoreImm(rd, virtAddr + 8);
+	}
+      case OP_JR:
+	EmitByte(0x44); EmitByte(0x8b); EmitByte(0xa3);
+	EmitWord(rs * 4);			// mov r12d, [rs]
+	break;
+
+      case OP_LB:
+      case OP_LBU:
+      case OP_LH:
+      case OP_LHU:
+      case OP_LW:
+	isLoad = TRUE;
+	// fall through
+      case OP_SB:
+      case OP_SH:
+      case OP_SW:
+	EmitByte(0x4c); EmitByte(0x89); EmitByte(0xef);	// mov rdi, r13
+	EmitLoadReg(ESI, rs);
+	EmitByte(0x81); EmitByte(0xc6); EmitWord(extra);	// add esi, extra
+	EmitByte(0x41); EmitByte(0xb8); EmitWord(index);	// mov r8d, index
+	if (isLoad) {
+	    EmitByte(0xba); EmitWord(instr->opCode);	// mov edx, opCode
+	    EmitByte(0x48); EmitByte(0x89); EmitByte(0xe1);	// mov rcx, rsp
+	    EmitCall((void *) Load);
+	} else {
+	    switch (instr->opCode) {
+	      case OP_SB: size = 1; break;
+	      case OP_SH: size = 2; break;
+	      case OP_SW: size = 4; break;
+	    }
+	    EmitByte(0xba); EmitWord(size);		// mov edx, size
+	    EmitLoadReg(ECX, rt);
+	    EmitCall((void *) Store);
+	}
+	EmitAccessCheck(index);
+	break;
+
+      default:
+	ASSERT(FALSE);		// BlockLength should have stopped us
+    }
+
+    EmitDelayedLoad(isLoad);
+    if (isLoad) {
+	EmitByte(0x8b); EmitByte(0x04); EmitByte(0x24);	// mov eax, [rsp]
+	EmitStoreReg(LoadValueReg, EAX);
+	EmitStoreImm(LoadReg, rt);
+	pendingLoad = rt;
+    }
+
+    // If this instruction waited for another thread, stop after it,
+    // as the interpreter would.
+    if (!last && (touchCode || size != 0 || isLoad)) {
+	EmitByte(0x83); EmitByte(0x7c); EmitByte(0x24); EmitByte(0x08);
+	EmitByte(Yielded);			// cmp dword [rsp+8], Yielded
+	EmitJumpToBail(0x84, index + 1);	// je bail
+    }
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::EmitAccessCheck
+// 	Generate the check of the status returned by Load, Store, or
+//	TouchCode: stop just before the instruction if the access
+//	failed, otherwise save the status for the end of the instruction.
+//
+//	"index" -- the position of the instruction in the block
+//----------------------------------------------------------------------
+
+void
+BinaryTranslator::EmitAccessCheck(int index)
+{
+    EmitByte(0x85); EmitByte(0xc0);			// test eax, eax
+    EmitJumpToBail(0x84, index);			// jz bail
+    EmitByte(0x89); EmitByte(0x44); EmitByte(0x24); EmitByte(0x08);
+							// mov [rsp+8], eax
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::EmitJumpToBail
+// 	Generate a conditional jump to the code that stops the block
+//	just before one of its instructions; Translate fills in the
+//	target once that code has been generated.
+//
+//	"condition" -- the second opcode byte of the jump (0x84 for jz)
+//	"index" -- the position of the instruction in the block
+//----------------------------------------------------------------------
+
+void
+BinaryTranslator::EmitJumpToBail(int condition, int index)
+{
+    ASSERT(numBails < 3 * MaxBlockLength);
+    EmitByte(0x0f); EmitByte(condition);
+    bailFrom[numBails] = next;
+    bailTo[numBails] = index;
+    numBails++;
+    EmitWord(0);
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::EmitDelayedLoad
+// 	Generate the host code for Machine::DelayedLoad, at the end of an
+//	instruction.  Most of the time we know at translation time which
+//	register (if any) the previous instruction loaded, so this is
+//	often nothing at all.
+//
+//	"isLoad" -- does this instruction start a delayed load of its own?
+//----------------------------------------------------------------------
+
+void
+BinaryTranslator::EmitDelayedLoad(bool isLoad)
+{
+    if (pendingLoad == NoLoad) {
+	return;
+    }
+    if (pendingLoad == UnknownLoad) {
+	EmitLoadReg(EAX, LoadReg);
+	EmitLoadReg(ECX, LoadValueReg);
+	EmitByte(0x89); EmitByte(0x0c); EmitByte(0x83);	// mov [rbx+rax*4], ecx
+	EmitStoreImm(0, 0);
+    } else if (pendingLoad != 0) {
+	EmitLoadReg(ECX, LoadValueReg);
+	EmitStoreReg(pendingLoad, ECX);
+    }
+    if (!isLoad) {
+	EmitStoreImm(LoadReg, 0);
+	EmitStoreImm(LoadValueReg, 0);
+    }
+    pendingLoad = NoLoad;
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::EmitExit
+// 	Generate the end of a block that ran to completion: bring the PC
+//	registers up to date, and return the number of instructions run.
+//
+//	"length" -- the number of instructions in the block
+//	"lastAddr" -- the virtual address of the last one
+//	"delaySlot" -- is the last one in the delay slot of a branch?
+//	"isBranch" -- is the last one a branch, whose delay slot didn't
+//		fit in the block?
+//----------------------------------------------------------------------
+
+void
+BinaryTranslator::EmitExit(int length, int lastAddr, bool delaySlot,
+			   bool isBranch)
+{
+    EmitStoreImm(PrevPCReg, lastAddr);
+    if (delaySlot) {
+	EmitByte(0x44); EmitByte(0x89); EmitByte(0xa3);
+	EmitWord(PCReg * 4);			// mov [PC], r12d
+	EmitByte(0x41); EmitByte(0x8d); EmitByte(0x44); EmitByte(0x24);
+	EmitByte(0x04);				// lea eax, [r12 + 4]
+	EmitStoreReg(NextPCReg, EAX);
+    } else if (isBranch) {
+	EmitStoreImm(PCReg, lastAddr + 4);
+	EmitByte(0x44); EmitByte(0x89); EmitByte(0xa3);
+	EmitWord(NextPCReg * 4);		// mov [NextPC], r12d
+    } else {
+	EmitStoreImm(PCReg, lastAddr + 4);
+	EmitStoreImm(NextPCReg, lastAddr + 8);
+    }
+    EmitReturn(length);
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::EmitBail
+// 	Generate the code to stop a block just before one of its
+//	instructions, leaving the machine exactly as the interpreter
+//	would have it at that point.
+//
+//	"index" -- the position of the instruction in the block
+//	"virtAddr" -- its user virtual address
+//	"delaySlot" -- is it in the delay slot of a branch?
+//----------------------------------------------------------------------
+
+void
+BinaryTranslator::EmitBail(int index, int virtAddr, bool delaySlot)
+{
+    if (index > 0) {
+	EmitStoreImm(PrevPCReg, virtAddr - 4);
+	EmitStoreImm(PCReg, virtAddr);
+	if (delaySlot) {
+	    EmitByte(0x44); EmitByte(0x89); EmitByte(0xa3);
+	    EmitWord(NextPCReg * 4);		// mov [NextPC], r12d
+	} else {
+	    EmitStoreImm(NextPCReg, virtAddr + 4);
+	}
+    }
+    EmitReturn(index);
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::EmitReturn
+// 	Generate the epilogue of a block, returning "numInstrs".
+//----------------------------------------------------------------------
+
+void
+BinaryTranslator::EmitReturn(int numInstrs)
+{
+    EmitByte(0xb8); EmitWord(numInstrs);		// mov eax, numInstrs
+    EmitByte(0x48); EmitByte(0x83); EmitByte(0xc4); EmitByte(0x10);
+							// add rsp, 16
+    EmitByte(0x41); EmitByte(0x5d);			// pop r13
+    EmitByte(0x41); EmitByte(0x5c);			// pop r12
+    EmitByte(0x5b);					// pop rbx
+    EmitByte(0xc3);					// ret
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::EmitCall
+// 	Generate a call to a C++ routine, whose arguments have been put
+//	in place already.
+//----------------------------------------------------------------------
+
+void
+BinaryTranslator::EmitCall(void *function)
+{
+    unsigned long long address = (unsigned long long) (unsigned long) function;
+
+    EmitByte(0x48); EmitByte(0xb8);			// mov rax, function
+    EmitWord((int) address);
+    EmitWord((int) (address >> 32));
+    EmitByte(0xff); EmitByte(0xd0);			// call rax
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::EmitWord
+// 	Put a 32-bit value into the code, in host (little endian) order.
+//----------------------------------------------------------------------
+
+void
+BinaryTranslator::EmitWord(int w)
+{
+    EmitByte(w & 0xff);
+    EmitByte((w >> 8) & 0xff);
+    EmitByte((w >> 16) & 0xff);
+    EmitByte((w >> 24) & 0xff);
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::EmitLoadReg, EmitStoreReg, EmitStoreImm, EmitArith
+// 	Generate moves between a host register and a simulated register,
+//	and arithmetic on eax with a simulated register.
+//----------------------------------------------------------------------
+
+void
+BinaryTranslator::EmitLoadReg(int hostReg, int reg)
+{
+    EmitByte(0x8b); EmitByte(0x83 | (hostReg << 3));	// mov r32, [rbx + d]
+    EmitWord(reg * 4);
+}
+
+void
+BinaryTranslator::EmitStoreReg(int reg, int hostReg)
+{
+    EmitByte(0x89); EmitByte(0x83 | (hostReg << 3));	// mov [rbx + d], r32
+    EmitWord(reg * 4);
+}
+
+void
+BinaryTranslator::EmitStoreImm(int reg, int value)
+{
+    EmitByte(0xc7); EmitByte(0x83);			// mov [rbx + d], imm
+    EmitWord(reg * 4);
+    EmitWord(value);
+}
+
+void
+BinaryTranslator::EmitArith(int op, int reg)
+{
+    EmitByte(op); EmitByte(0x83);			// op eax, [rbx + d]
+    EmitWord(reg * 4);
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::Access
+// 	Translate a virtual address for Load, Store, or TouchCode, as
+//	Machine::ReadMem or Machine::WriteMem would.  The instructions
+//	before this one are charged to the clock first, since translating
+//	may wait for another thread (which may run blocks of its own).
+//
+//	Returns Failed if the address can't be translated, without
+//	raising the exception; the interpreter will redo the instruction
+//	and raise it.  Otherwise returns Yielded if this or any earlier
+//	access in the block waited, so the block stops after the
+//	instruction.
+//
+//	"virtAddr" -- the virtual address to translate
+//	"physAddr" -- where to put the physical address
+//	"size" -- the number of bytes to be read or written
+//	"writing" -- is it for a store?
+//	"index" -- the position of the instruction in the block
+//----------------------------------------------------------------------
+
+BinaryTranslator::AccessStatus
+BinaryTranslator::Access(Machine *m, int virtAddr, int *physAddr, int size,
+			 bool writing, int index)
+{
+    BinaryTranslator *t = m->translator;
+    ExceptionType exception;
+    int charged;
+    bool yielded;
+    Ticks ticksBefore;
+
+    kernel->interrupt->AdvanceUserTime(index - t->charged);
+    charged = index;
+    yielded = t->yielded;
+    ticksBefore = kernel->stats->totalTicks;
+    exception = m->Translate(virtAddr, physAddr, size, writing);
+    t->charged = charged;
+    t->yielded = yielded || kernel->stats->totalTicks != ticksBefore;
+    if (exception != NoException) {
+	return Failed;
+    }
+    return t->yielded ? Yielded : Done;
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::Load
+// 	Called from translated code to do a load, as Machine::ReadMem
+//	would.  Returns the status from Access.
+//
+//	"addr" -- the virtual address to read
+//	"opCode" -- which load instruction it is
+//	"value" -- where to put the value, extended to a full word
+//	"index" -- the position of the instruction in the block
+//----------------------------------------------------------------------
+
+int
+BinaryTranslator::Load(Machine *m, int addr, int opCode, int *value, int index)
+{
+    int physAddr, size, data;
+    AccessStatus status;
+
+    switch (opCode) {
+      case OP_LB: case OP_LBU: size = 1; break;
+      case OP_LH: case OP_LHU: size = 2; break;
+      default: size = 4; break;
+    }
+    status = Access(m, addr, &physAddr, size, FALSE, index);
+    if (status == Failed) {
+	return Failed;
+    }
+    switch (opCode) {
+      case OP_LB:
+	data = (signed char) m->mainMemory[physAddr];
+	break;
+      case OP_LBU:
+	data = (unsigned char) m->mainMemory[physAddr];
+	break;
+      case OP_LH:
+	data = (short) ShortToHost(*(unsigned short *) &m->mainMemory[physAddr]);
+	break;
+      case OP_LHU:
+	data = ShortToHost(*(unsigned short *) &m->mainMemory[physAddr]);
+	break;
+      default:
+	data = WordToHost(*(unsigned int *) &m->mainMemory[physAddr]);
+	break;
+    }
+    *value = data;
+    return status;
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::Store
+// 	Called from translated code to do a store, as Machine::WriteMem
+//	would.  Returns the status from Access, or Failed if the store
+//	would change translated code; the interpreter will redo the
+//	instruction.
+//
+//	"addr" -- the virtual address to write
+//	"size" -- the number of bytes to write (1, 2, or 4)
+//	"value" -- the data to write
+//	"index" -- the position of the instruction in the block
+//----------------------------------------------------------------------
+
+int
+BinaryTranslator::Store(Machine *m, int addr, int size, int value, int index)
+{
+    int physAddr;
+    AccessStatus status;
+
+    status = Access(m, addr, &physAddr, size, TRUE, index);
+    if (status == Failed || m->translator->IsTranslated(physAddr)) {
+	return Failed;
+    }
+    m->decodeValid[physAddr / 4] = FALSE;
+    switch (size) {
+      case 1:
+	m->mainMemory[physAddr] = (unsigned char) (value & 0xff);
+	break;
+      case 2:
+	*(unsigned short *) &m->mainMemory[physAddr]
+		= ShortToMachine((unsigned short) (value & 0xffff));
+	break;
+      case 4:
+	*(unsigned int *) &m->mainMemory[physAddr]
+		= WordToMachine((unsigned int) value);
+	break;
+    }
+    return status;
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::TouchCode
+// 	Called from translated code to look up the page of the code
+//	being run again, as the interpreter does when it fetches an
+//	instruction, so that the page's use bit and place in any
+//	replacement order come out the same.  Returns the status from
+//	Access; the page may have been replaced while we waited for an
+//	earlier load or store.
+//
+//	"virtAddr" -- the user virtual address of an instruction
+//	"index" -- its position in the block
+//----------------------------------------------------------------------
+
+int
+BinaryTranslator::TouchCode(Machine *m, int virtAddr, int index)
+{
+    int physAddr;
+
+    return Access(m, virtAddr, &physAddr, 4, FALSE, index);
+}
+
+//----------------------------------------------------------------------
+// BinaryTranslator::Divide
+// 	Called from translated code for DIV and DIVU, which are simplest
+//	left to the C++ compiler.
+//----------------------------------------------------------------------
+
+void
+BinaryTranslator::Divide(int *registers, int rs, int rt, int opCode)
+{
+    if (registers[rt] == 0) {
+	registers[LoReg] = 0;
+	registers[HiReg] = 0;
+    } else if (opCode == OP_DIV) {
+	registers[LoReg] = registers[rs] / registers[rt];
+	registers[HiReg] = registers[rs] % registers[rt];
+    } else {
+	registers[LoReg] = (unsigned int) registers[rs] /
+				(unsigned int) registers[rt];
+	registers[HiReg] = (unsigned int) registers[rs] %
+				(unsigned int) registers[rt];
+    }
+}
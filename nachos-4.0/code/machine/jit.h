@@ -0,0 +1,152 @@
+// jit.h
+//	Data structures for translating frequently executed blocks of
+//	MIPS user code into native x86-64 code.
+//
+//	A block is a straight run of instructions within one physical
+//	page, ending with the delay slot of a branch or jump, or just
+//	before an instruction we don't translate (syscalls, unaligned
+//	loads and stores, anything illegal).  Blocks are found by counting
+//	how many times each physical word is executed as the start of a
+//	block; once a count passes HotThreshold, the block is translated
+//	into a code cache and run from there on.
+//
+//	Translated code has exactly the same effect on the simulated
+//	machine as the interpreter, instruction by instruction.  Whenever
+//	an instruction would trap (an overflow, a fault on a load or
+//	store) or would write into translated code, the block stops just
+//	before it, and the caller runs it with Machine::OneInstruction.
+//	As in RunBlock, the instructions run so far are charged to the
+//	clock before each memory access, and if the access made the
+//	thread wait for another one, the block stops after it.
+//
+//	The generated code is only correct on an x86-64 host.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef JIT_H
+#define JIT_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class Machine;
+class Instruction;
+
+// The host code for a block is called with the machine and its
+// register array, and returns how many user instructions it completed.
+// Anything less than the length of the block means it stopped early,
+// before an instruction that has to be interpreted.
+
+typedef int (*BlockCode)(Machine *machine, int *registers);
+
+// A translated block.  These live at the front of their code, in the
+// code cache.
+
+class TranslatedBlock {
+  public:
+    int virtAddr;		// user virtual address it was translated at
+    int length;			// number of user instructions in the block,
+				// 0 if the first one can't be translated
+    BlockCode code;		// the host code to run it
+};
+
+const int HotThreshold = 16;	// run a block this often before translating
+const int MaxBlockLength = 32;	// most user instructions in a block
+const int CodeCacheSize = 1024 * 1024;	// bytes of host code we keep
+
+class BinaryTranslator {
+  public:
+    BinaryTranslator(Machine *m);	// Initialize an empty code cache
+    ~BinaryTranslator();		// De-allocate the code cache
+
+    TranslatedBlock *Lookup(int physAddr, int virtAddr);
+				// Return the translation of the block
+				// starting at "physAddr", if there is one
+				// or it is now hot enough to make one;
+				// otherwise NULL
+
+    int Run(TranslatedBlock *block, int *charged, bool *yielded);
+				// Run a block's host code; say how many
+				// of its instructions were charged to
+				// the clock, and whether it stopped
+				// because another thread ran
+    bool IsTranslated(int physAddr) { return translated[physAddr / 4]; }
+				// Is the word at "physAddr" part of a
+				// translated block?
+    void InvalidatePage(unsigned int pageFrame);
+				// Throw away the translations of code in
+				// a physical page, because it has changed
+
+  private:
+    TranslatedBlock *Translate(int physAddr, int virtAddr);
+				// Generate host code for a block
+    int BlockLength(int physAddr, int *lastMemOp);
+				// How many instructions go in the block?
+    void Flush();		// Empty the whole code cache
+
+// Routines the host code calls, for what is too involved to generate.
+// Those that translate an address say whether the access failed, was
+// done, or was done but another thread ran meanwhile; "index" is the
+// position of the instruction in the block.
+    enum AccessStatus { Failed = 0, Done = 1, Yielded = 2 };
+    static int Load(Machine *m, int addr, int opCode, int *value,
+		    int index);
+    static int Store(Machine *m, int addr, int size, int value, int index);
+    static int TouchCode(Machine *m, int virtAddr, int index);
+    static AccessStatus Access(Machine *m, int virtAddr, int *physAddr,
+			       int size, bool writing, int index);
+    static void Divide(int *registers, int rs, int rt, int opCode);
+
+// The pieces of host code a block is made of
+    void EmitInstruction(Instruction *instr, int virtAddr, int index,
+			 bool delaySlot, bool touchCode, bool last);
+    void EmitAccessCheck(int index);
+    void EmitDelayedLoad(bool isLoad);
+    void EmitExit(int length, int lastAddr, bool delaySlot, bool isBranch);
+    void EmitBail(int index, int virtAddr, bool delaySlot);
+    void EmitJumpToBail(int condition, int index);
+    void EmitReturn(int numInstrs);
+    void EmitCall(void *function);
+    void EmitByte(int b) { *next++ = (unsigned char) b; }
+    void EmitWord(int w);
+    void EmitLoadReg(int hostReg, int reg);
+    void EmitStoreReg(int reg, int hostReg);
+    void EmitStoreImm(int reg, int value);
+    void EmitArith(int op, int reg);
+
+    Machine *machine;		// the machine whose code we translate
+    TranslatedBlock **blocks;	// translation starting at each physical
+				// word of "mainMemory", or NULL
+    bool *translated;		// is each word part of a translated block?
+    unsigned char *counts;	// how often each word has started a block
+				// that isn't translated yet
+    int *numBlocks;		// how many translations each page holds
+
+    unsigned char *cache;	// where the host code goes
+    unsigned char *next;	// first free byte of "cache"
+
+    unsigned char *bailFrom[3 * MaxBlockLength];
+				// the jumps in the block being translated
+				// that stop it early, to be filled in
+    int bailTo[3 * MaxBlockLength];
+				// the instruction each of them stops
+				// just before
+    int numBails;
+    int pendingLoad;		// register with a delayed load pending
+				// at this point of the block being
+				// translated; NoLoad if none, UnknownLoad
+				// if it can only be known at run time
+
+    int numRunning;		// blocks started and not yet finished;
+				// more than one if threads switched
+				// during memory accesses.  Their host
+				// code must stay where it is.
+    int charged;		// instructions of the running block
+				// charged to the clock so far
+    bool yielded;		// did another thread run during one of
+				// its memory accesses?
+};
+
+#endif // JIT_H
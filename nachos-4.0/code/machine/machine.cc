@@ -9,6 +9,8 @@
 
 #include "copyright.h"
 #include "machine.h"
+#include "jit.h"
+#include "profile.h"
 #include "main.h"
 
 // Textual names of the exceptions that can be generated by user program
@@ -44,23 +46,37 @@ void CheckEndian()
 #endif
 }
 
+// The size of user memory.  These are only changed at startup, before
+// the machine is created.
+
+unsigned int PageSize = DefaultPageSize;
+unsigned int NumPhysPages = DefaultNumPhysPages;
+
 //----------------------------------------------------------------------
 // Machine::Machine
 // 	Initialize the simulation of user program execution.
 //
 //	"debug" -- if TRUE, drop into the debugger after each user instruction
 //		is executed.
+//	"type" -- which simulator to run user instructions with
 //----------------------------------------------------------------------
 
-Machine::Machine(bool debug)
+Machine::Machine(bool debug, SimulatorType type)
 {
     int i;
 
+    ASSERT(PageSize > 0 && PageSize % 4 == 0 && NumPhysPages > 0);
+    kernel->stats->numPhysPages = NumPhysPages;
+    kernel->stats->pageSize = PageSize;
     for (i = 0; i < NumTotalRegs; i++)
         registers[i] = 0;
-    mainMemory = new char[MemorySize];
-    for (i = 0; i < MemorySize; i++)
+    mainMemory = new char[MemorySize()];
+    for (i = 0; i < MemorySize(); i++)
       	mainMemory[i] = 0;
+    decodeCache = new Instruction[MemorySize() / 4];
+    decodeValid = new bool[MemorySize() / 4];
+    for (i = 0; i < MemorySize() / 4; i++)
+	decodeValid[i] = FALSE;
 #ifdef USE_TLB
     tlb = new TranslationEntry[TLBSize];
     for (i = 0; i < TLBSize; i++)
@@ -70,8 +86,23 @@ Machine::Machine(bool debug)
     tlb = NULL;
     pageTable = NULL;
 #endif
+    FlushTransCache();
 
     singleStep = debug;
+#ifndef x86_64
+    if (type == BinaryTranslation) {
+	cout << "Binary translation needs an x86-64 host; ";
+	cout << "running basic blocks instead.\n";
+	type = BlockInterpreter;
+    }
+#endif
+    simulatorType = type;
+    translator = NULL;
+    if (type == BinaryTranslation)
+	translator = new BinaryTranslator(this);
+    profiler = NULL;
+    numAtBoundary = 0;
+    boundaryCall = NULL;
     CheckEndian();
 }
 
@@ -83,10 +114,55 @@ Machine::Machine(bool debug)
 Machine::~Machine()
 {
     delete [] mainMemory;
+    delete [] decodeCache;
+    delete [] decodeValid;
+    if (translator != NULL)
+	delete translator;
+    if (profiler != NULL) {
+	profiler->Print();
+	delete profiler;
+    }
     if (tlb != NULL)
         delete [] tlb;
 }
 
+//----------------------------------------------------------------------
+// Machine::StartProfiling
+// 	Count, from now on, how often each user instruction is run and
+//	how many page faults it takes.  The hot spots are reported when
+//	the machine is shut down, and every count is written to a file.
+//
+//	Profiling runs the user program with the plain interpreter, since
+//	it has to see every instruction.
+//
+//	"fileName" -- where to write the flat profile
+//----------------------------------------------------------------------
+
+void
+Machine::StartProfiling(char *fileName)
+{
+    ASSERT(profiler == NULL);
+    profiler = new Profiler(fileName);
+}
+
+//----------------------------------------------------------------------
+// Machine::CallAtBoundary
+// 	Arrange for "toCall->CallBack()" to be called from Run, the first
+//	time the clock has reached "when" between two user instructions.
+//	At that point the current thread is in user mode, and its user
+//	state is all in the machine registers and memory.
+//
+//	Used to take snapshots of a run.  Only one call can be pending.
+//----------------------------------------------------------------------
+
+void
+Machine::CallAtBoundary(CallBackObj *toCall, Ticks when)
+{
+    ASSERT(boundaryCall == NULL);
+    boundaryCall = toCall;
+    boundaryWhen = when;
+}
+
 //----------------------------------------------------------------------
 // Machine::RaiseException
 // 	Transfer control to the Nachos kernel from user mode, because
@@ -100,13 +176,19 @@ Machine::~Machine()
 void
 Machine::RaiseException(ExceptionType which, int badVAddr)
 {
+    Ticks ticksBefore;
+
     DEBUG(dbgMach, "Exception: " << exceptionNames[which]);
     
     registers[BadVAddrReg] = badVAddr;
     DelayedLoad(0, 0);			// finish anything in progress
     kernel->interrupt->setStatus(SystemMode);
 //	cout << "entering system mode...\n";
+    ticksBefore = kernel->stats->totalTicks;
     ExceptionHandler(which);		// interrupts are enabled at this point
+    if (profiler != NULL && which == PageFaultException)
+	profiler->Faulted(registers[PCReg],
+			  kernel->stats->totalTicks - ticksBefore);
     kernel->interrupt->setStatus(UserMode);
 //	cout << "entering user mode...\n";
 }
@@ -24,15 +24,23 @@
 #include "copyright.h"
 #include "utility.h"
 #include "translate.h"
+#include "stats.h"
 
-// Definitions related to the size, and format of user memory
+// Definitions related to the size, and format of user memory.
+// The page size and the number of physical pages can be set when
+// Nachos starts (-pagesize, -mem); these are the defaults.
 
-const unsigned int PageSize = 128; 		// set the page size equal to
+const unsigned int DefaultPageSize = 128; // set the page size equal to
 					// the disk sector size, for simplicity
 
-const unsigned int NumPhysPages = 32;
-const int MemorySize = (NumPhysPages * PageSize);
+const unsigned int DefaultNumPhysPages = 32;
+
+extern unsigned int PageSize;		// bytes in a page
+extern unsigned int NumPhysPages;	// pages of physical memory
+inline int MemorySize() { return NumPhysPages * PageSize; }
+					// bytes of physical memory
 const int TLBSize = 4;			// if there is a TLB, make it small
+const int TransCacheSize = 32;		// recent translations the machine keeps
 
 enum ExceptionType { NoException,           // Everything ok!
 		     SyscallException,      // A program executed a system call.
@@ -50,6 +58,17 @@ enum ExceptionType { NoException,           // Everything ok!
 		     NumExceptionTypes
 };
 
+// The ways the simulator can run user instructions.  All of them give the
+// same results, and charge the same simulated time.
+
+enum SimulatorType { Interpreter,	// decode and run one instruction
+					// at a time (the reference)
+		     BlockInterpreter,	// run a basic block at a time,
+					// with threaded dispatch
+		     BinaryTranslation	// translate hot blocks into host
+					// code (x86-64 hosts only)
+};
+
 // User program CPU state.  The full set of MIPS registers, plus a few
 // more because we need to be able to start/stop a user program between
 // any two instructions (thus we need to keep track of things like load
@@ -82,18 +101,56 @@ enum ExceptionType { NoException,           // Everything ok!
 // The procedures in this class are defined in machine.cc, mipssim.cc, and
 // translate.cc.
 
-class Instruction;
+// The following class defines an instruction, represented in both
+// 	undecoded binary form
+//      decoded to identify
+//	    operation to do
+//	    registers to act on
+//	    any immediate operand value
+
+class Instruction {
+  public:
+    void Decode();	// decode the binary representation of the instruction
+
+    unsigned int value; // binary representation of the instruction
+
+    unsigned char opCode; // Type of instruction.  This is NOT the same
+		     // as the opcode field from the instruction: see defs
+		     // in mipssim.h
+    unsigned char rs, rt, rd; // Three registers from instruction.
+    int extra;       // Immediate or target or shamt field or offset.
+                     // Immediates are sign-extended.
+};
+
 class Interrupt;
+class BinaryTranslator;
+class Profiler;
+class CallBackObj;
 
 class Machine {
   public:
-    Machine(bool debug);	// Initialize the simulation of the hardware
+    Machine(bool debug, SimulatorType type = Interpreter);
+				// Initialize the simulation of the hardware
 				// for running user programs
     ~Machine();			// De-allocate the data structures
 
 // Routines callable by the Nachos kernel
     void Run();	 		// Run a user program
 
+    void StartProfiling(char *fileName);
+				// Count what every user instruction does
+				// from now on; report it at halt, and
+				// write the counts to "fileName"
+
+    void CallAtBoundary(CallBackObj *toCall, Ticks when);
+				// Have Run call "toCall" once, between
+				// two user instructions, when the clock
+				// has reached "when"
+    int NumAtBoundary() { return numAtBoundary; }
+				// How many threads, other than the
+				// current one, were switched out by Run
+				// between two user instructions?
+
     int ReadRegister(int num);	// read the contents of a CPU register
 
     void WriteRegister(int num, int value);
@@ -132,14 +189,48 @@ class Machine {
     TranslationEntry *pageTable;
     unsigned int pageTableSize;
     bool ReadMem(int addr, int size, int* value);
+
+    void FlushTransCache();	// Forget the translations cached from the
+				// page table or TLB.  The kernel must call
+				// this whenever it changes a translation
+				// entry in use, or clears its use or
+				// dirty bit, and on every context switch.
+
+    void InvalidateDecodedPage(unsigned int pageFrame);
+				// Forget the decoded instructions cached
+				// for a physical page.  The kernel must
+				// call this whenever it changes the
+				// contents of "mainMemory" directly
+				// (loading code, swapping a page in),
+				// rather than through WriteMem.
   private:
 
 // Routines internal to the machine simulation -- DO NOT call these directly
     void DelayedLoad(int nextReg, int nextVal);  	
 				// Do a pending delayed load (modifying a reg)
 
-    void OneInstruction(Instruction *instr); 	
-    				// Run one instruction of a user program.
+    void OneInstruction(); 	// Run one instruction of a user program.
+
+    int RunBlock(int maxInstrs);	// Run user instructions up to the end
+				// of the current basic block, but no
+				// more than "maxInstrs" of them.  Returns
+				// how many were run and not yet charged
+				// to the simulated clock
+
+    void TickAtBoundary();	// Advance the clock, between two user
+				// instructions
+    int TicksUntilDue();	// How long until TickAtBoundary has
+				// something to do? (at most the
+				// largest int)
+
+    int RunTranslated(int maxInstrs);
+				// The same, but from translated code when
+				// the block is hot enough to have any
+
+    Instruction *FetchDecoded(int physAddr);
+				// Return the decoded form of the instruction
+				// word at "physAddr", decoding it only if
+				// it is not already in the decode cache
     
 //    bool ReadMem(int addr, int size, int* value);
     bool WriteMem(int addr, int size, int value);
@@ -166,12 +257,32 @@ class Machine {
 
     int registers[NumTotalRegs]; // CPU registers, for executing user programs
 
+    Instruction *decodeCache;	// decoded form of every instruction word
+				// in "mainMemory", indexed by physical
+				// word number
+    bool *decodeValid;		// TRUE if the matching decodeCache entry
+				// is up to date with "mainMemory"
+
+    TransCacheEntry transCache[TransCacheSize];
+				// recent translations, indexed by virtual
+				// page number modulo TransCacheSize
+
+    SimulatorType simulatorType; // how to run user instructions
+    BinaryTranslator *translator; // code cache, if we translate user code
+    Profiler *profiler;		// counts per instruction, if profiling
+
+    int numAtBoundary;		// threads switched out by TickAtBoundary
+    CallBackObj *boundaryCall;	// what TickAtBoundary should call,
+    Ticks boundaryWhen;		// and when, for CallAtBoundary
+
     bool singleStep;		// drop back into the debugger after each
 				// simulated instruction
-    int runUntilTime;		// drop back into the debugger when simulated
+    Ticks runUntilTime;		// drop back into the debugger when simulated
 				// time reaches this value
 
  friend class Interrupt;		// calls DelayedLoad()    
+ friend class BinaryTranslator;	// generates code that does the work
+				// of OneInstruction
 };
 
 extern void ExceptionHandler(ExceptionType which);
@@ -182,7 +293,11 @@ extern void ExceptionHandler(ExceptionType which);
 
 // Routines for converting Words and Short Words to and from the
 // simulated machine's format of little endian.  If the host machine
-// is little endian (DEC and Intel), these end up being NOPs.
+// is little endian (DEC and Intel), these end up being NOPs.  They are
+// called on every simulated memory reference, so the choice is made
+// when Nachos is compiled (HOST_IS_BIG_ENDIAN), and they are inline:
+// on a little endian host, a load or store of user memory is just a
+// load or store.
 //
 // What is stored in each format:
 //	host byte ordering:
@@ -191,9 +306,31 @@ extern void ExceptionHandler(ExceptionType which);
 //	simulated machine byte ordering:
 //	   contents of main memory
 
-unsigned int WordToHost(unsigned int word);
-unsigned short ShortToHost(unsigned short shortword);
-unsigned int WordToMachine(unsigned int word);
-unsigned short ShortToMachine(unsigned short shortword);
+inline unsigned int
+WordToHost(unsigned int word)
+{
+#ifdef HOST_IS_BIG_ENDIAN
+    return ((word >> 24) & 0x000000ff) | ((word >> 8) & 0x0000ff00) |
+	   ((word << 8) & 0x00ff0000) | ((word << 24) & 0xff000000);
+#else
+    return word;
+#endif // HOST_IS_BIG_ENDIAN
+}
+
+inline unsigned short
+ShortToHost(unsigned short shortword)
+{
+#ifdef HOST_IS_BIG_ENDIAN
+    return ((shortword << 8) & 0xff00) | ((shortword >> 8) & 0x00ff);
+#else
+    return shortword;
+#endif // HOST_IS_BIG_ENDIAN
+}
+
+inline unsigned int
+WordToMachine(unsigned int word) { return WordToHost(word); }
+
+inline unsigned short
+ShortToMachine(unsigned short shortword) { return ShortToHost(shortword); }
 
 #endif // MACHINE_H
@@ -0,0 +1,423 @@
+// mipsops.h
+//	What each MIPS instruction does, written once for both ways of
+//	running user code in mipssim.cc: OneInstruction, which switches
+//	on the opcode, and RunBlock, which jumps straight from one
+//	instruction's code to the next.
+//
+//	This is not a normal header: it is included in the middle of
+//	each of those routines, which first define the macros below to
+//	say how an instruction starts, ends, traps, and gets at memory.
+//
+//	OP(label, opcode)  -- the code for "opcode" starts here
+//	NEXT		   -- it is done
+//	NEXT_MEM	   -- it is done, after a load or store
+//	NEXT_BRANCH	   -- it is done, and the next instruction is
+//			      the delay slot of a branch or jump
+//	TRAP(which, addr)  -- raise exception "which" instead
+//	MEMORY(access)	   -- do a ReadMem or WriteMem, giving up on the
+//			      instruction if it returns FALSE
+//
+//	The routine including this provides "instr", and the variables
+//	sum, diff, tmp, value, rs, rt, imm, pcAfter, nextLoadReg and
+//	nextLoadValue.  Syscalls and illegal instructions are left to it.
+//
+//  DO NOT CHANGE -- part of the machine emulation
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+      OP(add, OP_ADD)
+	sum = registers[instr->rs] + registers[instr->rt];
+	if (!((registers[instr->rs] ^ registers[instr->rt]) & SIGN_BIT) &&
+	    ((registers[instr->rs] ^ sum) & SIGN_BIT))
+	    TRAP(OverflowException, 0);
+	registers[instr->rd] = sum;
+	NEXT;
+
+      OP(addi, OP_ADDI)
+	sum = registers[instr->rs] + instr->extra;
+	if (!((registers[instr->rs] ^ instr->extra) & SIGN_BIT) &&
+	    ((instr->extra ^ sum) & SIGN_BIT))
+	    TRAP(OverflowException, 0);
+	registers[instr->rt] = sum;
+	NEXT;
+
+      OP(addiu, OP_ADDIU)
+	registers[instr->rt] = registers[instr->rs] + instr->extra;
+	NEXT;
+
+      OP(addu, OP_ADDU)
+	registers[instr->rd] = registers[instr->rs] + registers[instr->rt];
+	NEXT;
+
+      OP(and_, OP_AND)
+	registers[instr->rd] = registers[instr->rs] & registers[instr->rt];
+	NEXT;
+
+      OP(andi, OP_ANDI)
+	registers[instr->rt] = registers[instr->rs] & (instr->extra & 0xffff);
+	NEXT;
+
+      OP(beq, OP_BEQ)
+	if (registers[instr->rs] == registers[instr->rt])
+	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
+	NEXT_BRANCH;
+
+      OP(bgezal, OP_BGEZAL)
+	registers[R31] = registers[NextPCReg] + 4;
+      OP(bgez, OP_BGEZ)
+	if (!(registers[instr->rs] & SIGN_BIT))
+	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
+	NEXT_BRANCH;
+
+      OP(bgtz, OP_BGTZ)
+	if (registers[instr->rs] > 0)
+	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
+	NEXT_BRANCH;
+
+      OP(blez, OP_BLEZ)
+	if (registers[instr->rs] <= 0)
+	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
+	NEXT_BRANCH;
+
+      OP(bltzal, OP_BLTZAL)
+	registers[R31] = registers[NextPCReg] + 4;
+      OP(bltz, OP_BLTZ)
+	if (registers[instr->rs] & SIGN_BIT)
+	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
+	NEXT_BRANCH;
+
+      OP(bne, OP_BNE)
+	if (registers[instr->rs] != registers[instr->rt])
+	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
+	NEXT_BRANCH;
+
+      OP(div, OP_DIV)
+	if (registers[instr->rt] == 0) {
+	    registers[LoReg] = 0;
+	    registers[HiReg] = 0;
+	} else {
+	    registers[LoReg] =  registers[instr->rs] / registers[instr->rt];
+	    registers[HiReg] = registers[instr->rs] % registers[instr->rt];
+	}
+	NEXT;
+
+      OP(divu, OP_DIVU)
+	  rs = (unsigned int) registers[instr->rs];
+	  rt = (unsigned int) registers[instr->rt];
+	  if (rt == 0) {
+	      registers[LoReg] = 0;
+	      registers[HiReg] = 0;
+	  } else {
+	      tmp = rs / rt;
+	      registers[LoReg] = (int) tmp;
+	      tmp = rs % rt;
+	      registers[HiReg] = (int) tmp;
+	  }
+	  NEXT;
+
+      OP(jal, OP_JAL)
+	registers[R31] = registers[NextPCReg] + 4;
+      OP(j, OP_J)
+	pcAfter = (pcAfter & 0xf0000000) | IndexToAddr(instr->extra);
+	NEXT_BRANCH;
+
+      OP(jalr, OP_JALR)
+	registers[instr->rd] = registers[NextPCReg] + 4;
+      OP(jr, OP_JR)
+	pcAfter = registers[instr->rs];
+	NEXT_BRANCH;
+
+      OP(lb, OP_LB)
+      OP(lbu, OP_LBU)
+	tmp = registers[instr->rs] + instr->extra;
+	MEMORY(ReadMem(tmp, 1, &value));
+
+	if ((value & 0x80) && (instr->opCode == OP_LB))
+	    value |= 0xffffff00;
+	else
+	    value &= 0xff;
+	nextLoadReg = instr->rt;
+	nextLoadValue = value;
+	NEXT_MEM;
+
+      OP(lh, OP_LH)
+      OP(lhu, OP_LHU)
+	tmp = registers[instr->rs] + instr->extra;
+	if (tmp & 0x1)
+	    TRAP(AddressErrorException, tmp);
+	MEMORY(ReadMem(tmp, 2, &value));
+
+	if ((value & 0x8000) && (instr->opCode == OP_LH))
+	    value |= 0xffff0000;
+	else
+	    value &= 0xffff;
+	nextLoadReg = instr->rt;
+	nextLoadValue = value;
+	NEXT_MEM;
+
+      OP(lui, OP_LUI)
+	DEBUG(dbgMach, "Executing: LUI r" << instr->rt << ", " << instr->extra);
+	registers[instr->rt] = instr->extra << 16;
+	NEXT;
+
+      OP(lw, OP_LW)
+	tmp = registers[instr->rs] + instr->extra;
+	if (tmp & 0x3)
+	    TRAP(AddressErrorException, tmp);
+	MEMORY(ReadMem(tmp, 4, &value));
+	nextLoadReg = instr->rt;
+	nextLoadValue = value;
+	NEXT_MEM;
+
+      OP(lwl, OP_LWL)
+	tmp = registers[instr->rs] + instr->extra;
+
+	// ReadMem assumes all 4 byte requests are aligned on an even
+	// word boundary.  Also, the little endian/big endian swap code would
+        // fail (I think) if the other cases are ever exercised.
+	ASSERT((tmp & 0x3) == 0);
+
+	MEMORY(ReadMem(tmp, 4, &value));
+	if (registers[LoadReg] == instr->rt)
+	    nextLoadValue = registers[LoadValueReg];
+	else
+	    nextLoadValue = registers[instr->rt];
+	switch (tmp & 0x3) {
+	  case 0:
+	    nextLoadValue = value;
+	    break;
+	  case 1:
+	    nextLoadValue = (nextLoadValue & 0xff) | (value << 8);
+	    break;
+	  case 2:
+	    nextLoadValue = (nextLoadValue & 0xffff) | (value << 16);
+	    break;
+	  case 3:
+	    nextLoadValue = (nextLoadValue & 0xffffff) | (value << 24);
+	    break;
+	}
+	nextLoadReg = instr->rt;
+	NEXT_MEM;
+
+      OP(lwr, OP_LWR)
+	tmp = registers[instr->rs] + instr->extra;
+
+	// ReadMem assumes all 4 byte requests are aligned on an even
+	// word boundary.  Also, the little endian/big endian swap code would
+        // fail (I think) if the other cases are ever exercised.
+	ASSERT((tmp & 0x3) == 0);
+
+	MEMORY(ReadMem(tmp, 4, &value));
+	if (registers[LoadReg] == instr->rt)
+	    nextLoadValue = registers[LoadValueReg];
+	else
+	    nextLoadValue = registers[instr->rt];
+	switch (tmp & 0x3) {
+	  case 0:
+	    nextLoadValue = (nextLoadValue & 0xffffff00) |
+		((value >> 24) & 0xff);
+	    break;
+	  case 1:
+	    nextLoadValue = (nextLoadValue & 0xffff0000) |
+		((value >> 16) & 0xffff);
+	    break;
+	  case 2:
+	    nextLoadValue = (nextLoadValue & 0xff000000)
+		| ((value >> 8) & 0xffffff);
+	    break;
+	  case 3:
+	    nextLoadValue = value;
+	    break;
+	}
+	nextLoadReg = instr->rt;
+	NEXT_MEM;
+
+      OP(mfhi, OP_MFHI)
+	registers[instr->rd] = registers[HiReg];
+	NEXT;
+
+      OP(mflo, OP_MFLO)
+	registers[instr->rd] = registers[LoReg];
+	NEXT;
+
+      OP(mthi, OP_MTHI)
+	registers[HiReg] = registers[instr->rs];
+	NEXT;
+
+      OP(mtlo, OP_MTLO)
+	registers[LoReg] = registers[instr->rs];
+	NEXT;
+
+      OP(mult, OP_MULT)
+	Mult(registers[instr->rs], registers[instr->rt], TRUE,
+	     &registers[HiReg], &registers[LoReg]);
+	NEXT;
+
+      OP(multu, OP_MULTU)
+	Mult(registers[instr->rs], registers[instr->rt], FALSE,
+	     &registers[HiReg], &registers[LoReg]);
+	NEXT;
+
+      OP(nor, OP_NOR)
+	registers[instr->rd] = ~(registers[instr->rs] | registers[instr->rt]);
+	NEXT;
+
+      OP(or_, OP_OR)
+	registers[instr->rd] = registers[instr->rs] | registers[instr->rt];
+	NEXT;
+
+      OP(ori, OP_ORI)
+	registers[instr->rt] = registers[instr->rs] | (instr->extra & 0xffff);
+	NEXT;
+
+      OP(sb, OP_SB)
+	MEMORY(WriteMem((unsigned)
+		(registers[instr->rs] + instr->extra), 1, registers[instr->rt]));
+	NEXT_MEM;
+
+      OP(sh, OP_SH)
+	MEMORY(WriteMem((unsigned)
+		(registers[instr->rs] + instr->extra), 2, registers[instr->rt]));
+	NEXT_MEM;
+
+      OP(sll, OP_SLL)
+	registers[instr->rd] = registers[instr->rt] << instr->extra;
+	NEXT;
+
+      OP(sllv, OP_SLLV)
+	registers[instr->rd] = registers[instr->rt] <<
+	    (registers[instr->rs] & 0x1f);
+	NEXT;
+
+      OP(slt, OP_SLT)
+	if (registers[instr->rs] < registers[instr->rt])
+	    registers[instr->rd] = 1;
+	else
+	    registers[instr->rd] = 0;
+	NEXT;
+
+      OP(slti, OP_SLTI)
+	if (registers[instr->rs] < instr->extra)
+	    registers[instr->rt] = 1;
+	else
+	    registers[instr->rt] = 0;
+	NEXT;
+
+      OP(sltiu, OP_SLTIU)
+	rs = registers[instr->rs];
+	imm = instr->extra;
+	if (rs < imm)
+	    registers[instr->rt] = 1;
+	else
+	    registers[instr->rt] = 0;
+	NEXT;
+
+      OP(sltu, OP_SLTU)
+	rs = registers[instr->rs];
+	rt = registers[instr->rt];
+	if (rs < rt)
+	    registers[instr->rd] = 1;
+	else
+	    registers[instr->rd] = 0;
+	NEXT;
+
+      OP(sra, OP_SRA)
+	registers[instr->rd] = registers[instr->rt] >> instr->extra;
+	NEXT;
+
+      OP(srav, OP_SRAV)
+	registers[instr->rd] = registers[instr->rt] >>
+	    (registers[instr->rs] & 0x1f);
+	NEXT;
+
+      OP(srl, OP_SRL)
+	tmp = registers[instr->rt];
+	tmp >>= instr->extra;
+	registers[instr->rd] = tmp;
+	NEXT;
+
+      OP(srlv, OP_SRLV)
+	tmp = registers[instr->rt];
+	tmp >>= (registers[instr->rs] & 0x1f);
+	registers[instr->rd] = tmp;
+	NEXT;
+
+      OP(sub, OP_SUB)
+	diff = registers[instr->rs] - registers[instr->rt];
+	if (((registers[instr->rs] ^ registers[instr->rt]) & SIGN_BIT) &&
+	    ((registers[instr->rs] ^ diff) & SIGN_BIT))
+	    TRAP(OverflowException, 0);
+	registers[instr->rd] = diff;
+	NEXT;
+
+      OP(subu, OP_SUBU)
+	registers[instr->rd] = registers[instr->rs] - registers[instr->rt];
+	NEXT;
+
+      OP(sw, OP_SW)
+	MEMORY(WriteMem((unsigned)
+		(registers[instr->rs] + instr->extra), 4, registers[instr->rt]));
+	NEXT_MEM;
+
+      OP(swl, OP_SWL)
+	tmp = registers[instr->rs] + instr->extra;
+
+	// The little endian/big endian swap code would
+        // fail (I think) if the other cases are ever exercised.
+	ASSERT((tmp & 0x3) == 0);
+
+	MEMORY(ReadMem((tmp & ~0x3), 4, &value));
+	switch (tmp & 0x3) {
+	  case 0:
+	    value = registers[instr->rt];
+	    break;
+	  case 1:
+	    value = (value & 0xff000000) | ((registers[instr->rt] >> 8) &
+					    0xffffff);
+	    break;
+	  case 2:
+	    value = (value & 0xffff0000) | ((registers[instr->rt] >> 16) &
+					    0xffff);
+	    break;
+	  case 3:
+	    value = (value & 0xffffff00) | ((registers[instr->rt] >> 24) &
+					    0xff);
+	    break;
+	}
+	MEMORY(WriteMem((tmp & ~0x3), 4, value));
+	NEXT_MEM;
+
+      OP(swr, OP_SWR)
+	tmp = registers[instr->rs] + instr->extra;
+
+	// The little endian/big endian swap code would
+        // fail (I think) if the other cases are ever exercised.
+	ASSERT((tmp & 0x3) == 0);
+
+	MEMORY(ReadMem((tmp & ~0x3), 4, &value));
+	switch (tmp & 0x3) {
+	  case 0:
+	    value = (value & 0xffffff) | (registers[instr->rt] << 24);
+	    break;
+	  case 1:
+	    value = (value & 0xffff) | (registers[instr->rt] << 16);
+	    break;
+	  case 2:
+	    value = (value & 0xff) | (registers[instr->rt] << 8);
+	    break;
+	  case 3:
+	    value = registers[instr->rt];
+	    break;
+	}
+	MEMORY(WriteMem((tmp & ~0x3), 4, value));
+	NEXT_MEM;
+
+      OP(xor_, OP_XOR)
+	registers[instr->rd] = registers[instr->rs] ^ registers[instr->rt];
+	NEXT;
+
+      OP(xori, OP_XORI)
+	registers[instr->rt] = registers[instr->rs] ^ (instr->extra & 0xffff);
+	NEXT;
@@ -15,30 +15,142 @@
 #include "debug.h"
 #include "machine.h"
 #include "mipssim.h"
+#include "jit.h"
+#include "profile.h"
 #include "main.h"
 
-static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
+/*
+ * The table below is used to translate bits 31:26 of the instruction
+ * into a value suitable for the "opCode" field of a MemWord structure,
+ * or into a special value for further decoding.
+ */
+
+#define SPECIAL 100
+#define BCOND	101
 
-// The following class defines an instruction, represented in both
-// 	undecoded binary form
-//      decoded to identify
-//	    operation to do
-//	    registers to act on
-//	    any immediate operand value
+#define IFMT 1
+#define JFMT 2
+#define RFMT 3
 
-class Instruction {
-  public:
-    void Decode();	// decode the binary representation of the instruction
+struct OpInfo {
+    int opCode;		/* Translated op code. */
+    int format;		/* Format type (IFMT or JFMT or RFMT) */
+};
 
-    unsigned int value; // binary representation of the instruction
+static OpInfo opTable[] = {
+    {SPECIAL, RFMT}, {BCOND, IFMT}, {OP_J, JFMT}, {OP_JAL, JFMT},
+    {OP_BEQ, IFMT}, {OP_BNE, IFMT}, {OP_BLEZ, IFMT}, {OP_BGTZ, IFMT},
+    {OP_ADDI, IFMT}, {OP_ADDIU, IFMT}, {OP_SLTI, IFMT}, {OP_SLTIU, IFMT},
+    {OP_ANDI, IFMT}, {OP_ORI, IFMT}, {OP_XORI, IFMT}, {OP_LUI, IFMT},
+    {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT},
+    {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT},
+    {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT},
+    {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT},
+    {OP_LB, IFMT}, {OP_LH, IFMT}, {OP_LWL, IFMT}, {OP_LW, IFMT},
+    {OP_LBU, IFMT}, {OP_LHU, IFMT}, {OP_LWR, IFMT}, {OP_RES, IFMT},
+    {OP_SB, IFMT}, {OP_SH, IFMT}, {OP_SWL, IFMT}, {OP_SW, IFMT},
+    {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_SWR, IFMT}, {OP_RES, IFMT},
+    {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT},
+    {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT},
+    {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT}, {OP_UNIMP, IFMT},
+    {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}, {OP_RES, IFMT}
+};
 
-    char opCode;     // Type of instruction.  This is NOT the same as the
-    		     // opcode field from the instruction: see defs in mips.h
-    char rs, rt, rd; // Three registers from instruction.
-    int extra;       // Immediate or target or shamt field or offset.
-                     // Immediates are sign-extended.
+/*
+ * The table below is used to convert the "funct" field of SPECIAL
+ * instructions into the "opCode" field of a MemWord.
+ */
+
+static int specialTable[] = {
+    OP_SLL, OP_RES, OP_SRL, OP_SRA, OP_SLLV, OP_RES, OP_SRLV, OP_SRAV,
+    OP_JR, OP_JALR, OP_RES, OP_RES, OP_SYSCALL, OP_UNIMP, OP_RES, OP_RES,
+    OP_MFHI, OP_MTHI, OP_MFLO, OP_MTLO, OP_RES, OP_RES, OP_RES, OP_RES,
+    OP_MULT, OP_MULTU, OP_DIV, OP_DIVU, OP_RES, OP_RES, OP_RES, OP_RES,
+    OP_ADD, OP_ADDU, OP_SUB, OP_SUBU, OP_AND, OP_OR, OP_XOR, OP_NOR,
+    OP_RES, OP_RES, OP_SLT, OP_SLTU, OP_RES, OP_RES, OP_RES, OP_RES,
+    OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES,
+    OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES, OP_RES
 };
 
+
+// Stuff to help print out each instruction, for debugging
+
+enum RegType { NONE, RS, RT, RD, EXTRA }; 
+
+struct OpString {
+    char *format;	// Printed version of instruction
+    RegType args[3];
+};
+
+static struct OpString opStrings[] = {
+	{"Shouldn't happen", {NONE, NONE, NONE}},
+	{"ADD r%d,r%d,r%d", {RD, RS, RT}},
+	{"ADDI r%d,r%d,%d", {RT, RS, EXTRA}},
+	{"ADDIU r%d,r%d,%d", {RT, RS, EXTRA}},
+	{"ADDU r%d,r%d,r%d", {RD, RS, RT}},
+	{"AND r%d,r%d,r%d", {RD, RS, RT}},
+	{"ANDI r%d,r%d,%d", {RT, RS, EXTRA}},
+	{"BEQ r%d,r%d,%d", {RS, RT, EXTRA}},
+	{"BGEZ r%d,%d", {RS, EXTRA, NONE}},
+	{"BGEZAL r%d,%d", {RS, EXTRA, NONE}},
+	{"BGTZ r%d,%d", {RS, EXTRA, NONE}},
+	{"BLEZ r%d,%d", {RS, EXTRA, NONE}},
+	{"BLTZ r%d,%d", {RS, EXTRA, NONE}},
+	{"BLTZAL r%d,%d", {RS, EXTRA, NONE}},
+	{"BNE r%d,r%d,%d", {RS, RT, EXTRA}},
+	{"Shouldn't happen", {NONE, NONE, NONE}},
+	{"DIV r%d,r%d", {RS, RT, NONE}},
+	{"DIVU r%d,r%d", {RS, RT, NONE}},
+	{"J %d", {EXTRA, NONE, NONE}},
+	{"JAL %d", {EXTRA, NONE, NONE}},
+	{"JALR r%d,r%d", {RD, RS, NONE}},
+	{"JR r%d,r%d", {RD, RS, NONE}},
+	{"LB r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"LBU r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"LH r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"LHU r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"LUI r%d,%d", {RT, EXTRA, NONE}},
+	{"LW r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"LWL r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"LWR r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"Shouldn't happen", {NONE, NONE, NONE}},
+	{"MFHI r%d", {RD, NONE, NONE}},
+	{"MFLO r%d", {RD, NONE, NONE}},
+	{"Shouldn't happen", {NONE, NONE, NONE}},
+	{"MTHI r%d", {RS, NONE, NONE}},
+	{"MTLO r%d", {RS, NONE, NONE}},
+	{"MULT r%d,r%d", {RS, RT, NONE}},
+	{"MULTU r%d,r%d", {RS, RT, NONE}},
+	{"NOR r%d,r%d,r%d", {RD, RS, RT}},
+	{"OR r%d,r%d,r%d", {RD, RS, RT}},
+	{"ORI r%d,r%d,%d", {RT, RS, EXTRA}},
+	{"RFE", {NONE, NONE, NONE}},
+	{"SB r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"SH r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"SLL r%d,r%d,%d", {RD, RT, EXTRA}},
+	{"SLLV r%d,r%d,r%d", {RD, RT, RS}},
+	{"SLT r%d,r%d,r%d", {RD, RS, RT}},
+	{"SLTI r%d,r%d,%d", {RT, RS, EXTRA}},
+	{"SLTIU r%d,r%d,%d", {RT, RS, EXTRA}},
+	{"SLTU r%d,r%d,r%d", {RD, RS, RT}},
+	{"SRA r%d,r%d,%d", {RD, RT, EXTRA}},
+	{"SRAV r%d,r%d,r%d", {RD, RT, RS}},
+	{"SRL r%d,r%d,%d", {RD, RT, EXTRA}},
+	{"SRLV r%d,r%d,r%d", {RD, RT, RS}},
+	{"SUB r%d,r%d,r%d", {RD, RS, RT}},
+	{"SUBU r%d,r%d,r%d", {RD, RS, RT}},
+	{"SW r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"SWL r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"SWR r%d,%d(r%d)", {RT, EXTRA, RS}},
+	{"XOR r%d,r%d,r%d", {RD, RS, RT}},
+	{"XORI r%d,r%d,%d", {RT, RS, EXTRA}},
+	{"SYSCALL", {NONE, NONE, NONE}},
+	{"Unimplemented", {NONE, NONE, NONE}},
+	{"Reserved", {NONE, NONE, NONE}}
+      };
+
+static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
+
 //----------------------------------------------------------------------
 // Machine::Run
 // 	Simulate the execution of a user-level program on Nachos.
@@ -46,21 +158,69 @@ class Instruction {
 //
 //	This routine is re-entrant, in that it can be called multiple
 //	times concurrently -- one for each thread executing user code.
+//
+//	Unless we are tracing or single stepping, the clock is only run
+//	through Interrupt::OneTick at the tick where the next pending
+//	interrupt is due; the ticks before that are just added on.
+//	Simulated time is exactly the same either way.
+//
+//	When profiling, every instruction is counted as it is run, so
+//	the block interpreter and translated code are not used.
 //----------------------------------------------------------------------
 
 void
 Machine::Run()
 {
-    Instruction *instr = new Instruction;  // storage for decoded instruction
-
     if (debug->IsEnabled('m')) {
         cout << "Starting program in thread: " << kernel->currentThread->getName();
 	cout << ", at time: " << kernel->stats->totalTicks << "\n";
     }
+    // Tracing and the debugger want to see every instruction, and every
+    // tick of the clock.
+    bool stepping = singleStep || debug->IsEnabled('m') ||
+			debug->IsEnabled(dbgInt);
+
     kernel->interrupt->setStatus(UserMode);
+    if (profiler != NULL) {
+	// count every instruction before it is run
+	for (;;) {
+	    profiler->Executed(registers[PCReg]);
+	    OneInstruction();
+	    TickAtBoundary();
+	    if (singleStep && (runUntilTime <= kernel->stats->totalTicks))
+		Debugger();
+	}
+    }
+    if (simulatorType != Interpreter && !stepping) {
+	for (;;) {
+	    // run as far as we can before the next interrupt is due, then
+	    // let OneTick handle it exactly as if we had come one at a time
+	    int ticks = TicksUntilDue();
+	    int maxInstrs = (ticks > 0) ? divRoundUp(ticks, UserTick) : 1;
+	    int numInstrs = (translator != NULL) ? RunTranslated(maxInstrs)
+						 : RunBlock(maxInstrs);
+
+	    kernel->interrupt->AdvanceUserTime(numInstrs - 1);
+	    TickAtBoundary();
+	}
+    }
+    if (!stepping) {
+	for (;;) {
+	    OneInstruction();
+
+	    // Until the clock reaches the next pending interrupt (or
+	    // CallAtBoundary's time), all OneTick would do is advance
+	    // it.  (Asked again after every instruction, since a syscall
+	    // may schedule a new interrupt.)
+	    if (TicksUntilDue() > UserTick)
+		kernel->interrupt->AdvanceUserTime(1);
+	    else
+		TickAtBoundary();
+	}
+    }
     for (;;) {
-        OneInstruction(instr);
-	kernel->interrupt->OneTick();
+        OneInstruction();
+	TickAtBoundary();
 	if (singleStep && (runUntilTime <= kernel->stats->totalTicks))
 	  Debugger();
     }
@@ -110,21 +270,29 @@ TypeToReg(RegType reg, Instruction *instr)
 //	leaving.  This allows the Nachos kernel to control our behavior
 //	by controlling the contents of memory, the translation table,
 //	and the register set.
+//
+//	The one thing we do keep between calls is the decoded form of
+//	each instruction word.  It belongs to physical memory, not to
+//	any thread, and is thrown away whenever that memory changes.
 //----------------------------------------------------------------------
 
 void
-Machine::OneInstruction(Instruction *instr)
+Machine::OneInstruction()
 {
-    int raw;
-    int nextLoadReg = 0; 	
+    Instruction *instr;
+    ExceptionType exception;
+    int physAddr;
+    int nextLoadReg = 0;
     int nextLoadValue = 0; 	// record delayed load operation, to apply
 				// in the future
 
-    // Fetch instruction 
-    if (!ReadMem(registers[PCReg], 4, &raw))
+    // Fetch instruction
+    exception = Translate(registers[PCReg], &physAddr, 4, FALSE);
+    if (exception != NoException) {
+	RaiseException(exception, registers[PCReg]);
 	return;			// exception occurred
-    instr->value = raw;
-    instr->Decode();
+    }
+    instr = FetchDecoded(physAddr);
 
     if (debug->IsEnabled('m')) {
         struct OpString *str = &opStrings[instr->opCode];
@@ -143,430 +311,22 @@ Machine::OneInstruction(Instruction *instr)
     unsigned int rs, rt, imm;
 
     // Execute the instruction (cf. Kane's book)
+#define OP(label, opcode)	case opcode:
+#define NEXT			break
+#define NEXT_MEM		break
+#define NEXT_BRANCH		break
+#define TRAP(which, badVAddr)	{ RaiseException(which, badVAddr); return; }
+#define MEMORY(access)		{ if (!(access)) return; }
+
     switch (instr->opCode) {
 	
-      case OP_ADD:
-	sum = registers[instr->rs] + registers[instr->rt];
-	if (!((registers[instr->rs] ^ registers[instr->rt]) & SIGN_BIT) &&
-	    ((registers[instr->rs] ^ sum) & SIGN_BIT)) {
-	    RaiseException(OverflowException, 0);
-	    return;
-	}
-	registers[instr->rd] = sum;
-	break;
-	
-      case OP_ADDI:
-	sum = registers[instr->rs] + instr->extra;
-	if (!((registers[instr->rs] ^ instr->extra) & SIGN_BIT) &&
-	    ((instr->extra ^ sum) & SIGN_BIT)) {
-	    RaiseException(OverflowException, 0);
-	    return;
-	}
-	registers[instr->rt] = sum;
-	break;
-	
-      case OP_ADDIU:
-	registers[instr->rt] = registers[instr->rs] + instr->extra;
-	break;
-	
-      case OP_ADDU:
-	registers[instr->rd] = registers[instr->rs] + registers[instr->rt];
-	break;
-	
-      case OP_AND:
-	registers[instr->rd] = registers[instr->rs] & registers[instr->rt];
-	break;
-	
-      case OP_ANDI:
-	registers[instr->rt] = registers[instr->rs] & (instr->extra & 0xffff);
-	break;
-	
-      case OP_BEQ:
-	if (registers[instr->rs] == registers[instr->rt])
-	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
-	break;
-	
-      case OP_BGEZAL:
-	registers[R31] = registers[NextPCReg] + 4;
-      case OP_BGEZ:
-	if (!(registers[instr->rs] & SIGN_BIT))
-	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
-	break;
-	
-      case OP_BGTZ:
-	if (registers[instr->rs] > 0)
-	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
-	break;
-	
-      case OP_BLEZ:
-	if (registers[instr->rs] <= 0)
-	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
-	break;
-	
-      case OP_BLTZAL:
-	registers[R31] = registers[NextPCReg] + 4;
-      case OP_BLTZ:
-	if (registers[instr->rs] & SIGN_BIT)
-	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
-	break;
-	
-      case OP_BNE:
-	if (registers[instr->rs] != registers[instr->rt])
-	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
-	break;
-	
-      case OP_DIV:
-	if (registers[instr->rt] == 0) {
-	    registers[LoReg] = 0;
-	    registers[HiReg] = 0;
-	} else {
-	    registers[LoReg] =  registers[instr->rs] / registers[instr->rt];
-	    registers[HiReg] = registers[instr->rs] % registers[instr->rt];
-	}
-	break;
-	
-      case OP_DIVU:	  
-	  rs = (unsigned int) registers[instr->rs];
-	  rt = (unsigned int) registers[instr->rt];
-	  if (rt == 0) {
-	      registers[LoReg] = 0;
-	      registers[HiReg] = 0;
-	  } else {
-	      tmp = rs / rt;
-	      registers[LoReg] = (int) tmp;
-	      tmp = rs % rt;
-	      registers[HiReg] = (int) tmp;
-	  }
-	  break;
-	
-      case OP_JAL:
-	registers[R31] = registers[NextPCReg] + 4;
-      case OP_J:
-	pcAfter = (pcAfter & 0xf0000000) | IndexToAddr(instr->extra);
-	break;
-	
-      case OP_JALR:
-	registers[instr->rd] = registers[NextPCReg] + 4;
-      case OP_JR:
-	pcAfter = registers[instr->rs];
-	break;
-	
-      case OP_LB:
-      case OP_LBU:
-	tmp = registers[instr->rs] + instr->extra;
-	if (!ReadMem(tmp, 1, &value))
-	    return;
-
-	if ((value & 0x80) && (instr->opCode == OP_LB))
-	    value |= 0xffffff00;
-	else
-	    value &= 0xff;
-	nextLoadReg = instr->rt;
-	nextLoadValue = value;
-	break;
-	
-      case OP_LH:
-      case OP_LHU:	  
-	tmp = registers[instr->rs] + instr->extra;
-	if (tmp & 0x1) {
-	    RaiseException(AddressErrorException, tmp);
-	    return;
-	}
-	if (!ReadMem(tmp, 2, &value))
-	    return;
-
-	if ((value & 0x8000) && (instr->opCode == OP_LH))
-	    value |= 0xffff0000;
-	else
-	    value &= 0xffff;
-	nextLoadReg = instr->rt;
-	nextLoadValue = value;
-	break;
-      	
-      case OP_LUI:
-	DEBUG(dbgMach, "Executing: LUI r" << instr->rt << ", " << instr->extra);
-	registers[instr->rt] = instr->extra << 16;
-	break;
-	
-      case OP_LW:
-	tmp = registers[instr->rs] + instr->extra;
-	if (tmp & 0x3) {
-	    RaiseException(AddressErrorException, tmp);
-	    return;
-	}
-	if (!ReadMem(tmp, 4, &value))
-	    return;
-	nextLoadReg = instr->rt;
-	nextLoadValue = value;
-	break;
-    	
-      case OP_LWL:	  
-	tmp = registers[instr->rs] + instr->extra;
-
-	// ReadMem assumes all 4 byte requests are aligned on an even 
-	// word boundary.  Also, the little endian/big endian swap code would
-        // fail (I think) if the other cases are ever exercised.
-	ASSERT((tmp & 0x3) == 0);  
-
-	if (!ReadMem(tmp, 4, &value))
-	    return;
-	if (registers[LoadReg] == instr->rt)
-	    nextLoadValue = registers[LoadValueReg];
-	else
-	    nextLoadValue = registers[instr->rt];
-	switch (tmp & 0x3) {
-	  case 0:
-	    nextLoadValue = value;
-	    break;
-	  case 1:
-	    nextLoadValue = (nextLoadValue & 0xff) | (value << 8);
-	    break;
-	  case 2:
-	    nextLoadValue = (nextLoadValue & 0xffff) | (value << 16);
-	    break;
-	  case 3:
-	    nextLoadValue = (nextLoadValue & 0xffffff) | (value << 24);
-	    break;
-	}
-	nextLoadReg = instr->rt;
-	break;
-      	
-      case OP_LWR:
-	tmp = registers[instr->rs] + instr->extra;
-
-	// ReadMem assumes all 4 byte requests are aligned on an even 
-	// word boundary.  Also, the little endian/big endian swap code would
-        // fail (I think) if the other cases are ever exercised.
-	ASSERT((tmp & 0x3) == 0);  
-
-	if (!ReadMem(tmp, 4, &value))
-	    return;
-	if (registers[LoadReg] == instr->rt)
-	    nextLoadValue = registers[LoadValueReg];
-	else
-	    nextLoadValue = registers[instr->rt];
-	switch (tmp & 0x3) {
-	  case 0:
-	    nextLoadValue = (nextLoadValue & 0xffffff00) |
-		((value >> 24) & 0xff);
-	    break;
-	  case 1:
-	    nextLoadValue = (nextLoadValue & 0xffff0000) |
-		((value >> 16) & 0xffff);
-	    break;
-	  case 2:
-	    nextLoadValue = (nextLoadValue & 0xff000000)
-		| ((value >> 8) & 0xffffff);
-	    break;
-	  case 3:
-	    nextLoadValue = value;
-	    break;
-	}
-	nextLoadReg = instr->rt;
-	break;
-    	
-      case OP_MFHI:
-	registers[instr->rd] = registers[HiReg];
-	break;
-	
-      case OP_MFLO:
-	registers[instr->rd] = registers[LoReg];
-	break;
-	
-      case OP_MTHI:
-	registers[HiReg] = registers[instr->rs];
-	break;
-	
-      case OP_MTLO:
-	registers[LoReg] = registers[instr->rs];
-	break;
-	
-      case OP_MULT:
-	Mult(registers[instr->rs], registers[instr->rt], TRUE,
-	     &registers[HiReg], &registers[LoReg]);
-	break;
-	
-      case OP_MULTU:
-	Mult(registers[instr->rs], registers[instr->rt], FALSE,
-	     &registers[HiReg], &registers[LoReg]);
-	break;
-	
-      case OP_NOR:
-	registers[instr->rd] = ~(registers[instr->rs] | registers[instr->rt]);
-	break;
-	
-      case OP_OR:
-	registers[instr->rd] = registers[instr->rs] | registers[instr->rs];
-	break;
-	
-      case OP_ORI:
-	registers[instr->rt] = registers[instr->rs] | (instr->extra & 0xffff);
-	break;
-	
-      case OP_SB:
-	if (!WriteMem((unsigned) 
-		(registers[instr->rs] + instr->extra), 1, registers[instr->rt]))
-	    return;
-	break;
-	
-      case OP_SH:
-	if (!WriteMem((unsigned) 
-		(registers[instr->rs] + instr->extra), 2, registers[instr->rt]))
-	    return;
-	break;
-	
-      case OP_SLL:
-	registers[instr->rd] = registers[instr->rt] << instr->extra;
-	break;
-	
-      case OP_SLLV:
-	registers[instr->rd] = registers[instr->rt] <<
-	    (registers[instr->rs] & 0x1f);
-	break;
-	
-      case OP_SLT:
-	if (registers[instr->rs] < registers[instr->rt])
-	    registers[instr->rd] = 1;
-	else
-	    registers[instr->rd] = 0;
-	break;
-	
-      case OP_SLTI:
-	if (registers[instr->rs] < instr->extra)
-	    registers[instr->rt] = 1;
-	else
-	    registers[instr->rt] = 0;
-	break;
-	
-      case OP_SLTIU:	  
-	rs = registers[instr->rs];
-	imm = instr->extra;
-	if (rs < imm)
-	    registers[instr->rt] = 1;
-	else
-	    registers[instr->rt] = 0;
-	break;
-      	
-      case OP_SLTU:	  
-	rs = registers[instr->rs];
-	rt = registers[instr->rt];
-	if (rs < rt)
-	    registers[instr->rd] = 1;
-	else
-	    registers[instr->rd] = 0;
-	break;
-      	
-      case OP_SRA:
-	registers[instr->rd] = registers[instr->rt] >> instr->extra;
-	break;
-	
-      case OP_SRAV:
-	registers[instr->rd] = registers[instr->rt] >>
-	    (registers[instr->rs] & 0x1f);
-	break;
-	
-      case OP_SRL:
-	tmp = registers[instr->rt];
-	tmp >>= instr->extra;
-	registers[instr->rd] = tmp;
-	break;
-	
-      case OP_SRLV:
-	tmp = registers[instr->rt];
-	tmp >>= (registers[instr->rs] & 0x1f);
-	registers[instr->rd] = tmp;
-	break;
-	
-      case OP_SUB:	  
-	diff = registers[instr->rs] - registers[instr->rt];
-	if (((registers[instr->rs] ^ registers[instr->rt]) & SIGN_BIT) &&
-	    ((registers[instr->rs] ^ diff) & SIGN_BIT)) {
-	    RaiseException(OverflowException, 0);
-	    return;
-	}
-	registers[instr->rd] = diff;
-	break;
-      	
-      case OP_SUBU:
-	registers[instr->rd] = registers[instr->rs] - registers[instr->rt];
-	break;
-	
-      case OP_SW:
-	if (!WriteMem((unsigned) 
-		(registers[instr->rs] + instr->extra), 4, registers[instr->rt]))
-	    return;
-	break;
-	
-      case OP_SWL:	  
-	tmp = registers[instr->rs] + instr->extra;
-
-	// The little endian/big endian swap code would
-        // fail (I think) if the other cases are ever exercised.
-	ASSERT((tmp & 0x3) == 0);  
-
-	if (!ReadMem((tmp & ~0x3), 4, &value))
-	    return;
-	switch (tmp & 0x3) {
-	  case 0:
-	    value = registers[instr->rt];
-	    break;
-	  case 1:
-	    value = (value & 0xff000000) | ((registers[instr->rt] >> 8) &
-					    0xffffff);
-	    break;
-	  case 2:
-	    value = (value & 0xffff0000) | ((registers[instr->rt] >> 16) &
-					    0xffff);
-	    break;
-	  case 3:
-	    value = (value & 0xffffff00) | ((registers[instr->rt] >> 24) &
-					    0xff);
-	    break;
-	}
-	if (!WriteMem((tmp & ~0x3), 4, value))
-	    return;
-	break;
-    	
-      case OP_SWR:	  
-	tmp = registers[instr->rs] + instr->extra;
-
-	// The little endian/big endian swap code would
-        // fail (I think) if the other cases are ever exercised.
-	ASSERT((tmp & 0x3) == 0);  
-
-	if (!ReadMem((tmp & ~0x3), 4, &value))
-	    return;
-	switch (tmp & 0x3) {
-	  case 0:
-	    value = (value & 0xffffff) | (registers[instr->rt] << 24);
-	    break;
-	  case 1:
-	    value = (value & 0xffff) | (registers[instr->rt] << 16);
-	    break;
-	  case 2:
-	    value = (value & 0xff) | (registers[instr->rt] << 8);
-	    break;
-	  case 3:
-	    value = registers[instr->rt];
-	    break;
-	}
-	if (!WriteMem((tmp & ~0x3), 4, value))
-	    return;
-	break;
-    	
+#include "mipsops.h"
+
       case OP_SYSCALL:
 	RaiseException(SyscallException, 0);
 //	return; 
 	break;
 	
-      case OP_XOR:
-	registers[instr->rd] = registers[instr->rs] ^ registers[instr->rt];
-	break;
-	
-      case OP_XORI:
-	registers[instr->rt] = registers[instr->rs] ^ (instr->extra & 0xffff);
-	break;
-	
       case OP_RES:
       case OP_UNIMP:
 	RaiseException(IllegalInstrException, 0);
@@ -575,6 +335,12 @@ Machine::OneInstruction(Instruction *instr)
       default:
 	ASSERT(FALSE);
     }
+#undef OP
+#undef NEXT
+#undef NEXT_MEM
+#undef NEXT_BRANCH
+#undef TRAP
+#undef MEMORY
     
     // Now we have successfully executed the instruction.
     
@@ -588,6 +354,249 @@ Machine::OneInstruction(Instruction *instr)
     registers[NextPCReg] = pcAfter;
 }
 
+//----------------------------------------------------------------------
+// Machine::TicksUntilDue
+// 	Return how many ticks Run can let pass without calling
+//	TickAtBoundary: until the next interrupt, or the call asked for
+//	with CallAtBoundary, whichever comes first.  That is only used to
+//	count instructions, so if it is more than an int holds, say so.
+//----------------------------------------------------------------------
+
+int
+Machine::TicksUntilDue()
+{
+    Ticks ticks = kernel->interrupt->TicksUntilNextInterrupt();
+
+    if (boundaryCall != NULL)
+	ticks = min(ticks, boundaryWhen - kernel->stats->totalTicks);
+    return (int) min(ticks, (Ticks) 0x7fffffff);
+}
+
+//----------------------------------------------------------------------
+// Machine::TickAtBoundary
+// 	Advance simulated time by one tick, between two user instructions,
+//	as Run does.  Keep count of the threads OneTick switches away from
+//	here (they are the ones whose user state is complete), and make
+//	the call CallAtBoundary asked for, once it is due.
+//----------------------------------------------------------------------
+
+void
+Machine::TickAtBoundary()
+{
+    CallBackObj *toCall;
+
+    numAtBoundary++;			// until we're switched back to
+    kernel->interrupt->OneTick();
+    numAtBoundary--;
+    if (boundaryCall != NULL && kernel->stats->totalTicks >= boundaryWhen) {
+	toCall = boundaryCall;
+	boundaryCall = NULL;		// it may ask to be called again
+	toCall->CallBack();
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::RunBlock
+// 	Execute user instructions up to the end of the current basic
+//	block (the delay slot after the next branch or jump), a syscall,
+//	or an exception, whichever comes first -- but never more than
+//	"maxInstrs" of them.
+//
+//	Each instruction has exactly the same effect as it would under
+//	OneInstruction, since both run the code for it in mipsops.h;
+//	what we save is the per-instruction overhead.  Dispatch goes straight from one opcode's code to the next
+//	through a table of labels (a GCC extension), and the PC is only
+//	re-translated when it leaves the run of sequential instructions
+//	in a page, or when a load or store might have changed the
+//	translation state behind our back.
+//
+//	Simulated time is not advanced per instruction.  The caller
+//	chooses "maxInstrs" so that no interrupt can become due inside
+//	the block, and charges the instructions we return; we charge any
+//	earlier ones ourselves before anything that can trap or switch
+//	threads, so the kernel always sees the correct time.
+//
+//	Returns the number of instructions executed and not yet charged
+//	to the clock (always at least one).
+//
+//	"maxInstrs" -- the most instructions to run before returning
+//----------------------------------------------------------------------
+
+// Charge the instructions run so far, except the current one.
+#define ChargeSoFar() \
+    { kernel->interrupt->AdvanceUserTime(count - charged); charged = count; }
+
+// Trap to the kernel with the current instruction unfinished.
+#define BlockException(which, badVAddr) \
+    { ChargeSoFar(); RaiseException(which, badVAddr); return 1; }
+
+// End the block after the current instruction if the last memory
+// access made us wait for another thread.
+#define CheckYielded() \
+    { if (kernel->stats->totalTicks != ticksBefore) blockEnd = count + 1; }
+
+// The next instruction is the delay slot; end the block after it.
+#define EndAfterDelaySlot() \
+    { if (blockEnd > count + 2) blockEnd = count + 2; }
+
+int
+Machine::RunBlock(int maxInstrs)
+{
+    static void *dispatch[MaxOpcode + 1] = {
+	&&bad, &&add, &&addi, &&addiu, &&addu, &&and_, &&andi, &&beq,
+	&&bgez, &&bgezal, &&bgtz, &&blez, &&bltz, &&bltzal, &&bne, &&bad,
+	&&div, &&divu, &&j, &&jal, &&jalr, &&jr, &&lb, &&lbu,
+	&&lh, &&lhu, &&lui, &&lw, &&lwl, &&lwr, &&bad, &&mfhi,
+	&&mflo, &&bad, &&mthi, &&mtlo, &&mult, &&multu, &&nor, &&or_,
+	&&ori, &&bad, &&sb, &&sh, &&sll, &&sllv, &&slt, &&slti,
+	&&sltiu, &&sltu, &&sra, &&srav, &&srl, &&srlv, &&sub, &&subu,
+	&&sw, &&swl, &&swr, &&xor_, &&xori, &&syscall, &&illegal, &&illegal
+    };
+    Instruction *instr;
+    ExceptionType exception;
+    int count = 0;		// instructions executed so far
+    int charged = 0;		// how many of those are already on the clock
+    int blockEnd = maxInstrs;	// stop when count reaches this
+    int physPC = 0;		// where registers[PCReg] is in mainMemory
+    int lastPC = 0;		// the virtual PC that physPC belongs to
+    bool translatePC = TRUE;	// must physPC be looked up again?
+    Ticks ticksBefore;
+    int nextLoadReg, nextLoadValue, pcAfter;
+    int sum, diff, tmp, value;
+    unsigned int rs, rt, imm;
+
+  next:
+    if (count >= blockEnd)
+	return count - charged;
+
+    // Fetch instruction.  Going through Translate again for every word
+    // of the same page would only repeat what it has already done.
+    if (translatePC || registers[PCReg] != lastPC + 4 ||
+	    ((unsigned) registers[PCReg] % PageSize) == 0) {
+	ChargeSoFar();
+	ticksBefore = kernel->stats->totalTicks;
+	exception = Translate(registers[PCReg], &physPC, 4, FALSE);
+	if (exception != NoException)
+	    BlockException(exception, registers[PCReg]);
+	CheckYielded();
+	translatePC = FALSE;
+    } else {
+	physPC += 4;
+    }
+    lastPC = registers[PCReg];
+    instr = FetchDecoded(physPC);
+
+    nextLoadReg = 0;
+    nextLoadValue = 0;
+    pcAfter = registers[NextPCReg] + 4;
+    goto *dispatch[instr->opCode];
+
+#define OP(label, opcode)	label:
+#define NEXT			goto retire
+#define NEXT_MEM		goto retireMem
+#define NEXT_BRANCH		{ EndAfterDelaySlot(); goto retire; }
+#define TRAP(which, badVAddr)	BlockException(which, badVAddr)
+#define MEMORY(access) \
+    { \
+	ChargeSoFar(); \
+	ticksBefore = kernel->stats->totalTicks; \
+	if (!(access)) \
+	    return 1; \
+	CheckYielded(); \
+    }
+
+#include "mipsops.h"
+
+#undef OP
+#undef NEXT
+#undef NEXT_MEM
+#undef NEXT_BRANCH
+#undef TRAP
+#undef MEMORY
+
+  syscall:
+    // The kernel may switch threads, or change our registers or memory,
+    // so this is always the last instruction of the block.
+    ChargeSoFar();
+    RaiseException(SyscallException, 0);
+    blockEnd = count + 1;
+    translatePC = TRUE;
+    goto retire;
+
+  illegal:
+    BlockException(IllegalInstrException, 0);
+
+  bad:
+    ASSERT(FALSE);
+
+  retireMem:
+    // The access may have changed the translation state (the LRU order
+    // of the pages, say), so look up the next PC the long way.
+    translatePC = TRUE;
+  retire:
+    // Now we have successfully executed the instruction.
+    DelayedLoad(nextLoadReg, nextLoadValue);
+    registers[PrevPCReg] = registers[PCReg];
+    registers[PCReg] = registers[NextPCReg];
+    registers[NextPCReg] = pcAfter;
+    count++;
+    goto next;
+}
+
+//----------------------------------------------------------------------
+// Machine::RunTranslated
+// 	Execute the block of user instructions at the PC from translated
+//	host code, if it has been run often enough to be translated and
+//	fits within "maxInstrs"; otherwise interpret it with RunBlock.
+//
+//	A translated block that stops early leaves the machine just before
+//	an instruction it couldn't do (a syscall, a trap, a store into
+//	translated code); we charge what did run, and then run that one
+//	instruction with OneInstruction.  It also stops just after a load
+//	or store that waited for another thread, as RunBlock does.
+//
+//	Returns the number of instructions executed and not yet charged
+//	to the clock (always at least one).
+//
+//	"maxInstrs" -- the most instructions to run before returning
+//----------------------------------------------------------------------
+
+int
+Machine::RunTranslated(int maxInstrs)
+{
+    TranslatedBlock *block;
+    ExceptionType exception;
+    int physAddr, numInstrs, charged;
+    bool yielded;
+
+    // A block can only be entered at the top, not in a delay slot.
+    if (registers[NextPCReg] != registers[PCReg] + 4)
+	return RunBlock(maxInstrs);
+
+    exception = Translate(registers[PCReg], &physAddr, 4, FALSE);
+    if (exception != NoException) {
+	RaiseException(exception, registers[PCReg]);
+	return 1;
+    }
+    block = translator->Lookup(physAddr, registers[PCReg]);
+    if (block == NULL || block->length > maxInstrs)
+	return RunBlock(maxInstrs);
+
+    if (block->length == 0) {		// nothing we could translate
+	OneInstruction();
+	return 1;
+    }
+    numInstrs = translator->Run(block, &charged, &yielded);
+    kernel->stats->numTranslatedInstrs += numInstrs;
+    if (numInstrs < block->length && (!yielded || charged == numInstrs)) {
+	// stopped just before an instruction it couldn't finish
+	kernel->interrupt->AdvanceUserTime(numInstrs - charged);
+	OneInstruction();
+	return 1;
+    }
+    return numInstrs - charged;
+}
+
 //----------------------------------------------------------------------
 // Machine::DelayedLoad
 // 	Simulate effects of a delayed load.
@@ -605,6 +614,49 @@ Machine::DelayedLoad(int nextReg, int nextValue)
     registers[0] = 0; 	// and always make sure R0 stays zero.
 }
 
+//----------------------------------------------------------------------
+// Machine::FetchDecoded
+// 	Return the decoded instruction stored at "physAddr" in main memory.
+//	The word is only decoded the first time it is executed; after that,
+//	the decoded copy is reused until the word (or its whole page) is
+//	overwritten.
+//
+//	"physAddr" -- the word-aligned physical address of the instruction
+//----------------------------------------------------------------------
+
+Instruction *
+Machine::FetchDecoded(int physAddr)
+{
+    int word = physAddr / 4;
+    Instruction *instr = &decodeCache[word];
+
+    if (!decodeValid[word]) {
+	instr->value = WordToHost(*(unsigned int *) &mainMemory[physAddr]);
+	instr->Decode();
+	decodeValid[word] = TRUE;
+    }
+    return instr;
+}
+
+//----------------------------------------------------------------------
+// Machine::InvalidateDecodedPage
+// 	Discard the decoded instructions of a physical page, because
+//	its contents are about to change (or just have) behind the
+//	simulator's back.
+//
+//	"pageFrame" -- the physical page number
+//----------------------------------------------------------------------
+
+void
+Machine::InvalidateDecodedPage(unsigned int pageFrame)
+{
+    ASSERT(pageFrame < NumPhysPages);
+    for (unsigned int i = 0; i < PageSize / 4; i++)
+	decodeValid[pageFrame * (PageSize / 4) + i] = FALSE;
+    if (translator != NULL)
+	translator->InvalidatePage(pageFrame);
+}
+
 //----------------------------------------------------------------------
 // Instruction::Decode
 // 	Decode a MIPS instruction 
@@ -32,17 +32,19 @@ NetworkInput::NetworkInput(CallBackObj *toCall)
 						 // in the current directory.
 
     // start polling for incoming packets
-    kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
+    poll = kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
 }
 
 //-----------------------------------------------------------------------
-// NetworkInput::NetworkInput
+// NetworkInput::~NetworkInput
 // 	Deallocate the simulation for the network input
-//		(basically, deallocate the input mailbox)
+//		(basically, stop polling and deallocate the input mailbox)
 //-----------------------------------------------------------------------
 
 NetworkInput::~NetworkInput()
 {
+    if (poll != NULL)
+	poll->Cancel();
     CloseSocket(sock);
     DeAssignNameToSocket(sockName);
 }
@@ -55,18 +57,20 @@ NetworkInput::~NetworkInput()
 //      First check to make sure packet is available & there's space to
 //	pull it in.  Then invoke the "callBack" registered by whoever 
 //	wants the packet.
+//
+//	There is no point polling again until the packet is taken out
+//	of the buffer, so then we stop, until Receive starts us again.
 //-----------------------------------------------------------------------
 
 void
 NetworkInput::CallBack()
 {
-    // schedule the next time to poll for a packet
-    kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
-
-    if (inHdr.length != 0) 	// do nothing if packet is already buffered
-	return;		
-    if (!PollSocket(sock)) 	// do nothing if no packet to be read
+    ASSERT(inHdr.length == 0);	// we don't poll with a packet buffered
+    poll = NULL;
+    if (!PollSocket(sock)) {	// nothing to be read; try again later
+	poll = kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
 	return;
+    }
 
     // otherwise, read packet in
     char *buffer = new char[MaxWireSize];
@@ -98,6 +102,8 @@ NetworkInput::Receive(char* data)
     inHdr.length = 0;
     if (hdr.length != 0) {
     	bcopy(inbox, data, hdr.length);
+	// there is room for the next packet; start polling for it
+	poll = kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
     }
     return hdr;
 }
@@ -19,6 +19,8 @@
 #include "utility.h"
 #include "callback.h"
 
+class PendingInterrupt;
+
 // Network address -- uniquely identifies a machine.  This machine's ID 
 //  is given on the command line.
 typedef int NetworkAddress;	 
@@ -78,6 +80,8 @@ class NetworkInput : public CallBackObj{
 				//   network
     PacketHeader inHdr;		// Information about arrived packet
     char inbox[MaxPacketSize];  // Data for arrived packet
+    PendingInterrupt *poll;	// When we next poll the network for a 
+				//   packet; NULL while one is buffered
 };
 
 class NetworkOutput : public CallBackObj {
@@ -0,0 +1,369 @@
+// profile.cc
+//	Routines to count where user programs spend their time.
+//	See profile.h for what is counted, and how it is reported.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "profile.h"
+#include "main.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+const int NumHotSpots = 20;	// instructions (and functions) to report
+
+//----------------------------------------------------------------------
+// ProgramProfile::ProgramProfile
+// 	Initialize the counts for a program, with no instructions run.
+//	Read its symbol table from "<programName>.sym", if there is one.
+//
+//	"programName" -- the file the program was loaded from
+//----------------------------------------------------------------------
+
+ProgramProfile::ProgramProfile(char *programName)
+{
+    char *symFileName = new char[strlen(programName) + 5];
+
+    name = programName;
+    numWords = 0;
+    executed = NULL;
+    faults = NULL;
+    stallTicks = NULL;
+    numSymbols = 0;
+    symbolAddr = NULL;
+    symbolName = NULL;
+
+    sprintf(symFileName, "%s.sym", programName);
+    ReadSymbols(symFileName);
+    delete [] symFileName;
+}
+
+//----------------------------------------------------------------------
+// ProgramProfile::~ProgramProfile
+// 	De-allocate the counts and the symbol table.
+//----------------------------------------------------------------------
+
+ProgramProfile::~ProgramProfile()
+{
+    delete [] executed;
+    delete [] faults;
+    delete [] stallTicks;
+    for (int i = 0; i < numSymbols; i++)
+	delete [] symbolName[i];
+    delete [] symbolAddr;
+    delete [] symbolName;
+}
+
+//----------------------------------------------------------------------
+// ProgramProfile::Grow
+// 	Make the counts cover at least the first "size" words of the
+//	program.  The arrays are doubled, so this is rarely needed.
+//----------------------------------------------------------------------
+
+void
+ProgramProfile::Grow(unsigned int size)
+{
+    unsigned int newWords = (numWords > 0) ? numWords : 1024;
+    long long *newExecuted, *newFaults;
+    Ticks *newStallTicks;
+
+    while (newWords < size)
+	newWords *= 2;
+    newExecuted = new long long[newWords];
+    newFaults = new long long[newWords];
+    newStallTicks = new Ticks[newWords];
+    for (unsigned int i = 0; i < newWords; i++) {
+	newExecuted[i] = (i < numWords) ? executed[i] : 0;
+	newFaults[i] = (i < numWords) ? faults[i] : 0;
+	newStallTicks[i] = (i < numWords) ? stallTicks[i] : 0;
+    }
+    delete [] executed;
+    delete [] faults;
+    delete [] stallTicks;
+    executed = newExecuted;
+    faults = newFaults;
+    stallTicks = newStallTicks;
+    numWords = newWords;
+}
+
+//----------------------------------------------------------------------
+// ProgramProfile::ReadSymbols
+// 	Read a symbol table, one function per line: its starting address
+//	in hex, then its name.  Leave the table empty if there is no
+//	such file.
+//----------------------------------------------------------------------
+
+void
+ProgramProfile::ReadSymbols(char *fileName)
+{
+    int fd = OpenForReadWrite(fileName, FALSE);
+    int size, addr, numLines, i;
+    char *buffer, *line, *next;
+    char symbol[256];
+
+    if (fd < 0)
+	return;
+    Lseek(fd, 0, 2);
+    size = Tell(fd);
+    Lseek(fd, 0, 0);
+    buffer = new char[size + 1];
+    Read(fd, buffer, size);
+    buffer[size] = '\0';
+    Close(fd);
+
+    numLines = 1;
+    for (i = 0; i < size; i++)
+	if (buffer[i] == '\n')
+	    numLines++;
+    symbolAddr = new int[numLines];
+    symbolName = new char *[numLines];
+
+    for (line = buffer; line != NULL && *line != '\0'; line = next) {
+	next = strchr(line, '\n');
+	if (next != NULL)
+	    *next++ = '\0';
+	if (sscanf(line, "%x %255s", &addr, symbol) != 2)
+	    continue;
+	// keep the table in address order; coff2noff writes it that way,
+	// so this is normally just an append
+	for (i = numSymbols; i > 0 && symbolAddr[i - 1] > addr; i--) {
+	    symbolAddr[i] = symbolAddr[i - 1];
+	    symbolName[i] = symbolName[i - 1];
+	}
+	symbolAddr[i] = addr;
+	symbolName[i] = new char[strlen(symbol) + 1];
+	strcpy(symbolName[i], symbol);
+	numSymbols++;
+    }
+    delete [] buffer;
+}
+
+//----------------------------------------------------------------------
+// ProgramProfile::FunctionAt
+// 	Return the name of the function that "virtAddr" is in: the last
+//	one starting at or below it.  NULL if there is none.
+//----------------------------------------------------------------------
+
+char *
+ProgramProfile::FunctionAt(int virtAddr)
+{
+    int low = 0, high = numSymbols;	// the answer is below "high"
+
+    while (low < high) {
+	int middle = (low + high) / 2;
+	if (symbolAddr[middle] <= virtAddr)
+	    low = middle + 1;
+	else
+	    high = middle;
+    }
+    return (low > 0) ? symbolName[low - 1] : NULL;
+}
+
+//----------------------------------------------------------------------
+// Profiler::Profiler
+// 	Initialize a profiler with nothing counted yet.
+//
+//	"flatFileName" -- where Print writes the flat profile
+//----------------------------------------------------------------------
+
+Profiler::Profiler(char *flatFileName)
+{
+    fileName = flatFileName;
+    programs = new List<ProgramProfile *>;
+    lastName = NULL;
+    lastProgram = NULL;
+}
+
+//----------------------------------------------------------------------
+// Profiler::~Profiler
+// 	De-allocate the counts of every program.
+//----------------------------------------------------------------------
+
+Profiler::~Profiler()
+{
+    while (!programs->IsEmpty())
+	delete programs->RemoveFront();
+    delete programs;
+}
+
+//----------------------------------------------------------------------
+// Profiler::Current
+// 	Return the counts for the program the current thread is running,
+//	starting new ones the first time it is seen.
+//----------------------------------------------------------------------
+
+ProgramProfile *
+Profiler::Current()
+{
+    char *name = kernel->currentThread->getName();
+
+    if (name == lastName)		// the usual case
+	return lastProgram;
+
+    lastName = name;
+    ListIterator<ProgramProfile *> iter(programs);
+    for (; !iter.IsDone(); iter.Next()) {
+	if (strcmp(iter.Item()->name, name) == 0) {
+	    lastProgram = iter.Item();
+	    return lastProgram;
+	}
+    }
+    lastProgram = new ProgramProfile(name);
+    programs->Append(lastProgram);
+    return lastProgram;
+}
+
+//----------------------------------------------------------------------
+// Profiler::Executed
+// 	Count one execution of the instruction at "pc".
+//----------------------------------------------------------------------
+
+void
+Profiler::Executed(int pc)
+{
+    ProgramProfile *program = Current();
+    unsigned int word = (unsigned) pc / 4;
+
+    if (word >= program->numWords)
+	program->Grow(word + 1);
+    program->executed[word]++;
+}
+
+//----------------------------------------------------------------------
+// Profiler::Faulted
+// 	Charge a page fault, and the "ticks" it took to service, to the
+//	instruction at "pc".
+//----------------------------------------------------------------------
+
+void
+Profiler::Faulted(int pc, Ticks ticks)
+{
+    ProgramProfile *program = Current();
+    unsigned int word = (unsigned) pc / 4;
+
+    if (word >= program->numWords)
+	program->Grow(word + 1);
+    program->faults[word]++;
+    program->stallTicks[word] += ticks;
+}
+
+// The counts qsort is ordering indices by, most first; ties go to the
+// lower index, so the output does not depend on the sort.
+static long long *sortCounts;
+
+static int
+CompareCounts(const void *a, const void *b)
+{
+    int x = *(const int *) a, y = *(const int *) b;
+
+    if (sortCounts[x] != sortCounts[y])
+	return (sortCounts[x] > sortCounts[y]) ? -1 : 1;
+    return x - y;
+}
+
+//----------------------------------------------------------------------
+// Profiler::Print
+// 	Print the instructions (and functions, if we have the symbols)
+//	each program spent the most time in, then write every count to
+//	the flat profile file.
+//----------------------------------------------------------------------
+
+void
+Profiler::Print()
+{
+    ListIterator<ProgramProfile *> iter(programs);
+    char buf[200];
+    int fd;
+
+    for (; !iter.IsDone(); iter.Next()) {
+	ProgramProfile *p = iter.Item();
+	long long total = 0, totalFaults = 0;
+	Ticks totalStall = 0;
+	int *order = new int[p->numWords];
+	int numRun = 0, i;
+
+	for (unsigned int w = 0; w < p->numWords; w++) {
+	    total += p->executed[w];
+	    totalFaults += p->faults[w];
+	    totalStall += p->stallTicks[w];
+	    if (p->executed[w] > 0 || p->faults[w] > 0)
+		order[numRun++] = w;
+	}
+	cout << "Profile of " << p->name << ": " << total
+	     << " instructions, " << totalFaults << " page faults, "
+	     << totalStall << " stall ticks\n";
+
+	sortCounts = p->executed;
+	qsort(order, numRun, sizeof(int), CompareCounts);
+	cout << "      address   executed      %  faults    stall  function\n";
+	for (i = 0; i < numRun && i < NumHotSpots; i++) {
+	    int w = order[i];
+	    char *function = p->FunctionAt(w * 4);
+	    sprintf(buf, "    %#9x %10lld %5.1f%% %7lld %8lld  %.80s\n", w * 4,
+		    p->executed[w], 100.0 * p->executed[w] / max(total, 1LL),
+		    p->faults[w], p->stallTicks[w],
+		    (function != NULL) ? function : "?");
+	    cout << buf;
+	}
+
+	if (p->numSymbols > 0) {	// add them up by function
+	    long long *funcExecuted = new long long[p->numSymbols];
+	    long long *funcFaults = new long long[p->numSymbols];
+	    Ticks *funcStall = new Ticks[p->numSymbols];
+	    int *funcOrder = new int[p->numSymbols];
+	    int f;
+
+	    for (f = 0; f < p->numSymbols; f++) {
+		funcExecuted[f] = funcFaults[f] = funcStall[f] = 0;
+		funcOrder[f] = f;
+	    }
+	    f = 0;
+	    for (unsigned int w = 0; w < p->numWords; w++) {
+		while (f + 1 < p->numSymbols &&
+		       p->symbolAddr[f + 1] <= (int) w * 4)
+		    f++;
+		if (p->symbolAddr[f] <= (int) w * 4) {
+		    funcExecuted[f] += p->executed[w];
+		    funcFaults[f] += p->faults[w];
+		    funcStall[f] += p->stallTicks[w];
+		}
+	    }
+	    sortCounts = funcExecuted;
+	    qsort(funcOrder, p->numSymbols, sizeof(int), CompareCounts);
+	    cout << "     executed      %  faults    stall  function\n";
+	    for (i = 0; i < p->numSymbols && i < NumHotSpots; i++) {
+		f = funcOrder[i];
+		if (funcExecuted[f] == 0 && funcFaults[f] == 0)
+		    break;
+		sprintf(buf, "   %10lld %5.1f%% %7lld %8lld  %.80s\n", funcExecuted[f],
+			100.0 * funcExecuted[f] / max(total, 1LL),
+			funcFaults[f], funcStall[f], p->symbolName[f]);
+		cout << buf;
+	    }
+	    delete [] funcExecuted;
+	    delete [] funcFaults;
+	    delete [] funcStall;
+	    delete [] funcOrder;
+	}
+	delete [] order;
+    }
+
+    fd = OpenForWrite(fileName);
+    ListIterator<ProgramProfile *> flatIter(programs);
+    for (; !flatIter.IsDone(); flatIter.Next()) {
+	ProgramProfile *p = flatIter.Item();
+	for (unsigned int w = 0; w < p->numWords; w++) {
+	    if (p->executed[w] == 0 && p->faults[w] == 0)
+		continue;
+	    char *function = p->FunctionAt(w * 4);
+	    sprintf(buf, "%.80s 0x%x %lld %lld %lld %.80s\n", p->name, w * 4,
+		    p->executed[w], p->faults[w], p->stallTicks[w],
+		    (function != NULL) ? function : "?");
+	    WriteFile(fd, buf, strlen(buf));
+	}
+    }
+    Close(fd);
+    cout << "Flat profile written to " << fileName << "\n";
+}
@@ -0,0 +1,83 @@
+// profile.h
+//	Data structures for profiling user programs.
+//
+//	With profiling on (-prof), the machine counts how many times each
+//	user instruction is run, how many page faults it causes, and how
+//	many ticks the program stalls while they are serviced.  Counts are
+//	kept for each program (by the name of the thread running it, which
+//	is the file given with -e), indexed by virtual address.
+//
+//	If a file "<program>.sym" exists -- coff2noff writes one when it is
+//	given a third file name -- the counts are also added up by function.
+//
+//	At halt, a report of the hot spots is printed, and a flat profile
+//	(one line per instruction that was run, in address order) is
+//	written to a file, so that two runs can be compared with diff.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "list.h"
+#include "stats.h"
+
+// The counts for one program.
+
+class ProgramProfile {
+  public:
+    ProgramProfile(char *programName);	// Initialize empty counts, and
+					// read the program's symbols
+    ~ProgramProfile();			// De-allocate the counts
+
+    void Grow(unsigned int size);	// Make room to count the first
+					// "size" words of the program
+
+    char *FunctionAt(int virtAddr);	// Name of the function holding
+					// "virtAddr", or NULL if not known
+
+    char *name;			// the program's file name
+    unsigned int numWords;	// how many words the counts cover
+    long long *executed;	// times each word was run as an instruction
+    long long *faults;		// page faults taken by each instruction
+    Ticks *stallTicks;		// ticks spent waiting for those faults
+
+    int numSymbols;		// functions in the symbol file, if any
+    int *symbolAddr;		// where each one starts, in increasing order
+    char **symbolName;		// and what it is called
+
+  private:
+    void ReadSymbols(char *fileName);	// Fill in the symbol table
+};
+
+// The profiler itself.  Machine::Run calls Executed before every
+// instruction, and Machine::RaiseException calls Faulted after the
+// kernel has serviced a page fault.
+
+class Profiler {
+  public:
+    Profiler(char *flatFileName);	// Start with no counts; the flat
+					// profile goes to "flatFileName"
+    ~Profiler();			// De-allocate the counts
+
+    void Executed(int pc);		// The instruction at "pc" is run
+    void Faulted(int pc, Ticks ticks);	// It took a page fault, which
+					// stalled it for "ticks"
+
+    void Print();			// Print the hot spots, and write
+					// the flat profile
+
+  private:
+    ProgramProfile *Current();		// Counts for the running program
+
+    char *fileName;			// where the flat profile goes
+    List<ProgramProfile *> *programs;	// every program seen so far
+    char *lastName;			// the thread name Current last saw,
+    ProgramProfile *lastProgram;	// and the counts for its program
+};
+
+#endif // PROFILE_H
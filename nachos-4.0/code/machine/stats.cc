@@ -22,6 +22,11 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numPhysPages = pageSize = 0;
+    numTranslatedBlocks = numTranslatedInstrs = 0;
+    numStackHits = numStackMisses = numThreadHits = numThreadMisses = 0;
+    maxStackCommitted = 0;
+    hostStartTime = HostTime();
 }
 
 //----------------------------------------------------------------------
@@ -39,7 +44,40 @@ Statistics::Print()
 		cout << ", writes " << numDiskWrites << "\n";
 		cout << "Console I/O: reads " << numConsoleCharsRead;
     cout << ", writes " << numConsoleCharsWritten << "\n";
-    cout << "Paging: faults " << numPageFaults << "\n";
+    cout << "Paging: faults " << numPageFaults;
+    if (numPhysPages > 0) {
+	cout << ", memory " << numPhysPages << " pages of " << pageSize
+	     << " bytes";
+	if (userTicks > 0) {
+	    cout << ", " << 1000.0 * numPageFaults / (userTicks / UserTick)
+		 << " faults per 1000 instructions";
+	}
+    }
+    cout << "\n";
     cout << "Network I/O: packets received " << numPacketsRecvd;
 		cout << ", sent " << numPacketsSent << "\n";
+    if (userTicks > 0) {
+	Ticks numInstrs = userTicks / UserTick;
+	double seconds = HostTime() - hostStartTime;
+
+	cout << "Simulator: " << numInstrs << " user instructions in ";
+		cout << seconds << " host seconds";
+	if (seconds > 0) {
+	    cout << ", " << (long long) (numInstrs / seconds) << " per second";
+	}
+	cout << "\n";
+    }
+    if (numTranslatedBlocks > 0) {
+	cout << "Translation: blocks " << numTranslatedBlocks;
+		cout << ", instructions run translated " << numTranslatedInstrs << "\n";
+    }
+    if (numStackHits + numStackMisses > 0) {
+	cout << "Thread pool: stacks " << numStackHits << " hits, ";
+		cout << numStackMisses << " misses; Thread objects ";
+		cout << numThreadHits << " hits, " << numThreadMisses << " misses\n";
+    }
+    if (maxStackCommitted > 0) {
+	cout << "Thread stacks: peak committed " << maxStackCommitted;
+		cout << " bytes\n";
+    }
 }
@@ -13,6 +13,11 @@
 
 #include "copyright.h"
 
+// Simulated time, in ticks.  64 bits, so that the clock doesn't wrap
+// around (after 2^31 ticks, with an int) on long runs.
+
+typedef long long Ticks;
+
 // The following class defines the statistics that are to be kept
 // about Nachos behavior -- how much time (ticks) elapsed, how
 // many user instructions executed, etc.
@@ -21,20 +26,37 @@
 
 class Statistics {
   public:
-    int totalTicks;      	// Total time running Nachos
-    int idleTicks;       	// Time spent idle (no threads to run)
-    int systemTicks;	 	// Time spent executing system code
-    int userTicks;       	// Time spent executing user code
+    Ticks totalTicks;      	// Total time running Nachos
+    Ticks idleTicks;       	// Time spent idle (no threads to run)
+    Ticks systemTicks;	 	// Time spent executing system code
+    Ticks userTicks;       	// Time spent executing user code
 				// (this is also equal to # of
 				// user instructions executed)
 
-    int numDiskReads;		// number of disk read requests
-    int numDiskWrites;		// number of disk write requests
-    int numConsoleCharsRead;	// number of characters read from the keyboard
-    int numConsoleCharsWritten; // number of characters written to the display
-    int numPageFaults;		// number of virtual memory page faults
-    int numPacketsSent;		// number of packets sent over the network
-    int numPacketsRecvd;	// number of packets received over the network
+    // the event counts are 64 bits as well, to keep up with the clock
+    long long numDiskReads;	// number of disk read requests
+    long long numDiskWrites;	// number of disk write requests
+    long long numConsoleCharsRead; // number of characters read from the keyboard
+    long long numConsoleCharsWritten; // number of characters written to the display
+    long long numPageFaults;	// number of virtual memory page faults
+    int numPhysPages;		// the size of physical memory (0 if no
+    int pageSize;		// user programs), to go with the faults
+    long long numPacketsSent;	// number of packets sent over the network
+    long long numPacketsRecvd;	// number of packets received over the network
+    long long numTranslatedBlocks; // number of user code blocks translated
+				// into host code
+    long long numTranslatedInstrs; // number of user instructions executed
+				// as translated host code
+    long long numStackHits;	// number of thread stacks reused from
+    long long numStackMisses;	// the pool, and allocated afresh
+    long long numThreadHits;	// the same, for Thread objects
+    long long numThreadMisses;
+    long long maxStackCommitted; // the most host memory committed to
+				// the stack of a thread, when it was
+				// deleted (in bytes)
+
+    double hostStartTime;	// host wall clock time at startup, to
+				// measure how fast the simulator runs
 
     Statistics(); 		// initialize everything to zero
 
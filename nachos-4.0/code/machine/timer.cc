@@ -33,14 +33,32 @@
 //      "doRandom" -- if true, arrange for the interrupts to occur
 //		at random, instead of fixed, intervals.
 //      "toCall" is the interrupt handler to call when the timer expires.
+//      "doTickless" -- if true, don't interrupt until WakeAfter asks for it.
 //----------------------------------------------------------------------
 
-Timer::Timer(bool doRandom, CallBackObj *toCall)
+Timer::Timer(bool doRandom, CallBackObj *toCall, bool doTickless)
 {
-    randomize = doRandom;
+    randomize = doRandom && !doTickless;
     callPeriodically = toCall;
     disable = FALSE;
-    SetInterrupt();
+    tickless = doTickless;
+    lastTick = kernel->stats->totalTicks;
+    armed = NULL;
+    if (!tickless)
+	SetInterrupt();
+}
+
+//----------------------------------------------------------------------
+// Timer::~Timer
+//      Turn off a tickless timer, by calling off the interrupt it was
+//	asked for.  (A periodic timer doesn't keep track of its
+//	interrupts; the machine is shut down after it is anyway.)
+//----------------------------------------------------------------------
+
+Timer::~Timer()
+{
+    if (armed != NULL)
+	armed->Cancel();
 }
 
 //----------------------------------------------------------------------
@@ -52,6 +70,14 @@ Timer::Timer(bool doRandom, CallBackObj *toCall)
 void 
 Timer::CallBack() 
 {
+    if (tickless) {
+	armed = NULL;
+	callPeriodically->CallBack();	// which will re-arm us, if need be
+	return;
+    }
+
+    lastTick = kernel->stats->totalTicks;	// a new time slice begins
+
     // invoke the Nachos interrupt handler for this device
     callPeriodically->CallBack();
     
@@ -79,3 +105,105 @@ Timer::SetInterrupt()
        kernel->interrupt->Schedule(this, delay, TimerInt);
     }
 }
+
+//----------------------------------------------------------------------
+// Timer::CountTicks
+//      Return how many time slices have ended since the last call, and
+//	count them.  A periodic timer interrupts at the end of every
+//	one, so that is always 1 for it; a tickless one may have
+//	skipped some.
+//----------------------------------------------------------------------
+
+long long
+Timer::CountTicks()
+{
+    long long ticks;
+
+    if (!tickless)
+	return 1;
+    ticks = UncountedTicks();
+    lastTick += ticks * TimerTicks;
+    return ticks;
+}
+
+//----------------------------------------------------------------------
+// Timer::UncountedTicks
+//      Return how many time slices have ended since the ones last
+//	counted by CountTicks, without counting them.
+//----------------------------------------------------------------------
+
+long long
+Timer::UncountedTicks()
+{
+    if (!tickless)
+	return 0;
+    return (kernel->stats->totalTicks - lastTick) / TimerTicks;
+}
+
+//----------------------------------------------------------------------
+// Timer::SliceStart
+//      Return when the current time slice began: for a periodic timer,
+//	when it last interrupted; for a tickless one, at the end of the
+//	last time slice to go by, counted or not.
+//----------------------------------------------------------------------
+
+Ticks
+Timer::SliceStart()
+{
+    return lastTick + UncountedTicks() * TimerTicks;
+}
+
+//----------------------------------------------------------------------
+// Timer::WakeAfter
+//      For a tickless timer, arrange to interrupt at the end of the
+//	"ticks"th time slice after the last counted one -- or of the
+//	current one, if that is already past -- unless we are armed
+//	to interrupt by then anyway.  If we are armed for later, the
+//	interrupt is moved up.
+//
+//	A periodic timer will interrupt by then anyway.
+//
+//	"ticks" -- how many time slices; 0 if we aren't needed
+//----------------------------------------------------------------------
+
+void
+Timer::WakeAfter(long long ticks)
+{
+    Ticks now = kernel->stats->totalTicks;
+    Ticks when;
+
+    if (!tickless || disable || ticks <= 0)
+	return;
+    if (ticks <= (now - lastTick) / TimerTicks)
+	ticks = (now - lastTick) / TimerTicks + 1;
+    when = lastTick + ticks * TimerTicks;
+    if (armed == NULL)
+	armed = kernel->interrupt->Schedule(this, when - now, TimerInt);
+    else if (armed->when > when)
+	armed->Reschedule(when);
+}
+
+//----------------------------------------------------------------------
+// Timer::WakeAt
+//      For a tickless timer, arrange to interrupt at time "when" -- or
+//	right away, if that is already past -- unless we are armed to
+//	interrupt by then anyway.  Unlike WakeAfter, "when" need not be
+//	at the end of a time slice.
+//
+//	A periodic timer only interrupts at the end of its time slices.
+//----------------------------------------------------------------------
+
+void
+Timer::WakeAt(Ticks when)
+{
+    Ticks now = kernel->stats->totalTicks;
+
+    if (!tickless || disable)
+	return;
+    if (when <= now)
+	when = now + 1;
+    if (armed == NULL)
+	armed = kernel->interrupt->Schedule(this, when - now, TimerInt);
+    else if (armed->when > when)
+	armed->Reschedule(when);
+}
@@ -11,6 +11,14 @@
 //	In order to introduce some randomness into time-slicing, if "doRandom"
 //	is set, then the interrupt comes after a random number of ticks.
 //
+//	A "tickless" timer does not interrupt on its own: it keeps time in
+//	the same TimerTicks steps, but goes off only when asked to (by
+//	WakeAfter), at the step the software needs, and can then skip any
+//	number of steps.  The software finds out how many went by from
+//	CountTicks.  Randomness does not apply to a tickless timer.
+//	A tickless timer can also be asked (by WakeAt) to go off at any
+//	given tick, in between the steps.
+//
 //  DO NOT CHANGE -- part of the machine emulation
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
@@ -23,24 +31,45 @@
 #include "copyright.h"
 #include "utility.h"
 #include "callback.h"
+#include "interrupt.h"
 
 // The following class defines a hardware timer. 
 class Timer : public CallBackObj {
   public:
-    Timer(bool doRandom, CallBackObj *toCall);
+    Timer(bool doRandom, CallBackObj *toCall, bool doTickless);
 				// Initialize the timer, and callback to "toCall"
-				// every time slice.
-    virtual ~Timer() {}
+				// every time slice (or, if "doTickless", when
+				// asked to).
+    virtual ~Timer();		// Call off the next interrupt, if
+				// we know about it
     
     void Disable() { disable = TRUE; }
     				// Turn timer device off, so it doesn't
 				// generate any more interrupts.
 
+    bool IsTickless() { return tickless; }
+    long long CountTicks();	// Number of time slices since the last
+				// time this was called
+    long long UncountedTicks();	// Number of them that have gone by since,
+				// without counting them
+    Ticks SliceStart();		// When the current time slice began
+    void WakeAfter(long long ticks); // Tickless: make sure we interrupt by the
+				// "ticks"th time slice since the last
+				// counted one
+    void WakeAt(Ticks when);	// Tickless: make sure we interrupt by
+				// time "when"
+
   private:
     bool randomize;		// set if we need to use a random timeout delay
     CallBackObj *callPeriodically; // call this every TimerTicks time units 
     bool disable;		// turn off the timer device after next
     				// interrupt.
+    bool tickless;		// interrupt only when asked to
+    Ticks lastTick;		// when the last counted time slice ended
+				// (for a periodic timer, when it last
+				// interrupted)
+    PendingInterrupt *armed;	// the interrupt we were last asked for,
+				// if it has not occurred yet
     
     void CallBack();		// called internally when the hardware
 				// timer generates an interrupt
@@ -42,4 +42,18 @@ class TranslationEntry {
 			// page is modified.
 };
 
+// An entry in the machine's translation cache remembers where in
+// "mainMemory" a virtual page was found the last time it was translated,
+// so the next access to it can skip the page table (or TLB) lookup.
+
+class TransCacheEntry {
+  public:
+    bool readable;	// If this bit is clear, the entry is empty.
+    bool writable;	// If this bit is set, the page may be written
+			// without going back to its translation entry
+			// (its dirty bit is set already).
+    unsigned int virtualPage;	// The page number in virtual memory.
+    char *page;		// Where that page starts in "mainMemory".
+};
+
 #endif
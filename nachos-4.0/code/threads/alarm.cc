@@ -18,17 +18,20 @@
 //
 //      "doRandom" -- if true, arrange for the hardware interrupts to 
 //		occur at random, instead of fixed, intervals.
+//      "tickless" -- if true, have the hardware interrupt only when
+//		we need it to.
 //----------------------------------------------------------------------
 
-Alarm::Alarm(bool doRandom)
+Alarm::Alarm(bool doRandom, bool tickless)
 {
-    timer = new Timer(doRandom, this);
+    timer = new Timer(doRandom, this, tickless);
 }
 
 //----------------------------------------------------------------------
 // Alarm::CallBack
 //	Software interrupt handler for the timer device. The timer device is
-//	set up to interrupt the CPU periodically (once every TimerTicks).
+//	set up to interrupt the CPU periodically (once every TimerTicks),
+//	or in tickless mode, at the end of the time slices Rearm asks for.
 //	This routine is called each time there is a timer interrupt,
 //	with interrupts disabled.
 //
@@ -59,5 +62,20 @@ Alarm::CallBack()
     } else {			// there's someone to preempt
 	interrupt->YieldOnReturn();
     }
+    Rearm();			// in case we are tickless
 }
 
+//----------------------------------------------------------------------
+// Alarm::Rearm
+//	In tickless mode, arrange for the timer to go off when the
+//	scheduler next needs it.  Called after each timer interrupt, and
+//	whenever that may have become sooner: a thread was made ready,
+//	or went to sleep.  Interrupts are disabled.
+//----------------------------------------------------------------------
+
+void
+Alarm::Rearm()
+{
+    if (timer->IsTickless())
+	timer->WakeAfter(kernel->scheduler->TicksNeeded());
+}
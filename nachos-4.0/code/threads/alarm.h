@@ -8,6 +8,12 @@
 //	From this, we provide the ability for a thread to be
 //	woken up after a delay; we also provide time-slicing.
 //
+//	In tickless mode (-tickless), the timer only goes off when the
+//	scheduler needs it to: at the end of the current time slice if
+//	a thread is waiting to be switched to, or when the first
+//	sleeping thread is due; otherwise it stays quiet, so an idle
+//	machine skips straight to its next real event.
+//
 //	NOTE: this abstraction is not completely implemented.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
@@ -25,11 +31,20 @@
 // The following class defines a software alarm clock. 
 class Alarm : public CallBackObj {
   public:
-    Alarm(bool doRandomYield);	// Initialize the timer, and callback 
+    Alarm(bool doRandomYield, bool tickless);
+				// Initialize the timer, and callback 
 				// to "toCall" every time slice.
     ~Alarm() { delete timer; }
     
     void WaitUntil(int x);	// suspend execution until time > now + x
+    void WaitTicks(Ticks n);	// suspend execution for at least n ticks
+				// (not just whole time slices)
+
+    void Rearm();		// tickless: make sure the timer goes off
+				// when the scheduler next needs it
+    Ticks SliceStart() { return timer->SliceStart(); }
+				// when the current time slice began
+    bool IsTickless() { return timer->IsTickless(); }
 
   private:
     Timer *timer;		// the hardware timer device
@@ -44,6 +44,7 @@ class ThreadedKernel {
 
   private:
     bool randomSlice;		// enable pseudo-random time slicing
+    bool tickless;		// have the timer go off only when needed
 };
 
 
@@ -6,6 +6,7 @@
 //   -u prints entire set of legal flags
 //   -z prints copyright string
 //   -d causes certain debugging messages to be printed (cf. debug.h)
+//   -switchbench times context switches on the host before the selftest
 //
 //  NOTE: Other flags are defined for each assignment, and
 //  incorrect flag usage is not caught.
@@ -57,6 +58,7 @@ main(int argc, char **argv)
 {
     int i;
     char *debugArg = "";
+    int switchBench = 0;
 
     // before anything else, initialize the debugging system
     for (i = 1; i < argc; i++) {
@@ -64,8 +66,17 @@ main(int argc, char **argv)
 	    ASSERT(i + 1 < argc);   // next argument is debug string
             debugArg = argv[i + 1];
 	    i++;
+	} else if (strcmp(argv[i], "-switchbench") == 0) {
+	    ASSERT(i + 1 < argc);   // next argument is how many switches
+            switchBench = atoi(argv[i + 1]);
+	    if (switchBench < 2) {
+		cout << "-switchbench needs at least 2 switches; ignored\n";
+		switchBench = 0;
+	    }
+	    i++;
 	} else if (strcmp(argv[i], "-u") == 0) {
             cout << "Partial usage: nachos [-z -d debugFlags]\n";
+            cout << "Partial usage: nachos [-switchbench switches]\n";
 	} else if (strcmp(argv[i], "-z") == 0) {
             cout << copyright;
 	}
@@ -80,6 +91,8 @@ main(int argc, char **argv)
     
     CallOnUserAbort(Cleanup);		// if user hits ctl-C
 
+    if (switchBench > 0)
+	Thread::SwitchBenchmark(switchBench);
     kernel->SelfTest();
     kernel->Run();
     
@@ -32,7 +32,7 @@
 Scheduler::Scheduler()
 {
 //	schedulerType = type;
-	readyList = new List<Thread *>; 
+	readyList = new ThreadQueue; 
 	toBeDestroyed = NULL;
 } 
 
@@ -62,6 +62,7 @@ Scheduler::ReadyToRun (Thread *thread)
 
     thread->setStatus(READY);
     readyList->Append(thread);
+    kernel->alarm->Rearm();		// it may need a time slice
 }
 
 //----------------------------------------------------------------------
@@ -184,3 +185,23 @@ Scheduler::Print()
     cout << "Ready list contents:\n";
     readyList->Apply(ThreadPrint);
 }
+
+//----------------------------------------------------------------------
+// Scheduler::TicksNeeded
+// 	Return at the end of which time slice, counting from the last
+//	one the timer counted, the timer next needs to go off; 0 if it
+//	doesn't.  Only used in tickless mode (see Alarm::Rearm).
+//
+//	We need it at the end of the current slice if there is a ready
+//	thread to switch to.  When the CPU is idle, the first ready
+//	thread will just be run, so it needs another one to compete with.
+//----------------------------------------------------------------------
+
+long long
+Scheduler::TicksNeeded()
+{
+    unsigned int competing = 
+	(kernel->interrupt->getStatus() == IdleMode) ? 2 : 1;
+
+    return (readyList->NumInList() >= competing) ? 1 : 0;
+}
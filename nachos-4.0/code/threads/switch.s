@@ -11,6 +11,7 @@
  *	    SUN SPARC (SPARC)
  *	    HP PA-RISC (PARISC)
  *	    Intel 386 (x86)
+ *	    x86-64 (x86_64)
  *	    IBM RS6000 (PowerPC) -- I hope it will also work for Mac PowerPC
  *
  * We define two routines for each architecture:
@@ -371,6 +372,77 @@ SWITCH:
 #endif // x86
 
 
+#ifdef x86_64
+
+        .text
+        .align  16
+
+        .globl  ThreadRoot
+
+/* void ThreadRoot( void )
+**
+** expects the following registers to be initialized:
+**      r15     points to startup function (interrupt enable)
+**      r13     contains inital argument to thread function
+**      r12     points to thread function
+**      r14     point to Thread::Finish()
+**
+** These are all callee-saved, so they survive the calls.  We are
+** entered by the "ret" in SWITCH, with the stack as at the start
+** of a function; pushing rbp aligns it to 16 bytes for the calls.
+*/
+ThreadRoot:
+        pushq   %rbp
+        movq    %rsp,%rbp
+        call    *StartupPC
+        movq    InitialArg,%rdi
+        call    *InitialPC
+        call    *WhenDonePC
+
+        # NOT REACHED
+        movq    %rbp,%rsp
+        popq    %rbp
+        ret
+
+
+
+/* void SWITCH( thread *t1, thread *t2 )
+**
+** on entry, t1 is in rdi, t2 in rsi, and the stack looks like this:
+**       (rsp)  ->              return address
+**
+** Only the callee-saved registers are saved and restored: rbx, rbp,
+** and r12 to r15 (and rsp).  The return address goes with them, so
+** that a new thread can "return" into ThreadRoot.
+*/
+        .globl  SWITCH
+SWITCH:
+        movq    %rsp,_RSP(%rdi)         # save stack pointer
+        movq    %rbx,_RBX(%rdi)         # save registers
+        movq    %rbp,_RBP(%rdi)
+        movq    %r12,_R12(%rdi)
+        movq    %r13,_R13(%rdi)
+        movq    %r14,_R14(%rdi)
+        movq    %r15,_R15(%rdi)
+        movq    0(%rsp),%rax            # get return address from stack
+        movq    %rax,_PC(%rdi)          # save it into the pc storage
+
+        movq    _RBX(%rsi),%rbx         # restore registers
+        movq    _RBP(%rsi),%rbp
+        movq    _R12(%rsi),%r12
+        movq    _R13(%rsi),%r13
+        movq    _R14(%rsi),%r14
+        movq    _R15(%rsi),%r15
+        movq    _RSP(%rsi),%rsp         # restore stack pointer
+        movq    _PC(%rsi),%rax          # restore return address
+        movq    %rax,0(%rsp)            # copy it over the one on the stack
+        ret
+
+        .section .note.GNU-stack,"",@progbits   # no executable stack
+
+#endif // x86_64
+
+
 
 #ifdef PowerPC
                 .globl branch[ds]
@@ -18,15 +18,19 @@
 //
 // Once we'e implemented one set of higher level atomic operations,
 // we can implement others using that implementation.  We illustrate
-// this by implementing locks and condition variables on top of 
-// semaphores, instead of directly enabling and disabling interrupts.
+// this by implementing locks on top of semaphores, instead of
+// directly enabling and disabling interrupts.
 //
 // Locks are implemented using a semaphore to keep track of
 // whether the lock is held or not -- a semaphore value of 0 means
 // the lock is busy; a semaphore value of 1 means the lock is free.
 //
-// The implementation of condition variables using semaphores is
-// a bit trickier, as explained below under Condition::Wait.
+// Condition variables queue and wake their waiters directly, as
+// semaphores do, so that waiting needs no semaphore of its own; see
+// Condition::Wait.
+//
+// Waiting threads are queued through links in the threads themselves,
+// so that none of these operations allocates memory.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -48,7 +52,6 @@ Semaphore::Semaphore(char* debugName, int initialValue)
 {
     name = debugName;
     value = initialValue;
-    queue = new List<Thread *>;
 }
 
 //----------------------------------------------------------------------
@@ -59,7 +62,7 @@ Semaphore::Semaphore(char* debugName, int initialValue)
 
 Semaphore::~Semaphore()
 {
-    delete queue;
+    ASSERT(queue.IsEmpty());
 }
 
 char*
@@ -87,7 +90,7 @@ Semaphore::P()
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	
     
     while (value == 0) { 		// semaphore not available
-	queue->Append(currentThread);	// so go to sleep
+	queue.Append(currentThread);	// so go to sleep
 	currentThread->Sleep(FALSE);
     } 
     value--; 			// semaphore available, consume its value
@@ -112,8 +115,8 @@ Semaphore::V()
     // disable interrupts
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	
     
-    if (!queue->IsEmpty()) {  // make thread ready.
-	kernel->scheduler->ReadyToRun(queue->RemoveFront());
+    if (!queue.IsEmpty()) {  // make thread ready.
+	kernel->scheduler->ReadyToRun(queue.RemoveFront());
     }
     value++;
     
@@ -228,7 +231,6 @@ Lock::IsHeldByCurrentThread()
 Condition::Condition(char* debugName)
 {
     name = debugName;
-    waitQueue = new List<Semaphore *>;
 }
 
 //----------------------------------------------------------------------
@@ -238,7 +240,7 @@ Condition::Condition(char* debugName)
 
 Condition::~Condition()
 {
-    delete waitQueue;
+    ASSERT(waitQueue.IsEmpty());
 }
 
 char*
@@ -249,11 +251,10 @@ Condition::getName()
 //----------------------------------------------------------------------
 // Condition::Wait
 // 	Atomically release monitor lock and go to sleep.
-//	Our implementation uses semaphores to implement this, by
-//	allocating a semaphore for each waiting thread.  The signaller
-//	will V() this semaphore, so there is no chance the waiter
-//	will miss the signal, even though the lock is released before
-//	calling P().
+//	The waiting thread goes on the condition's queue through a link
+//	in its own Thread object, and sleeps with interrupts disabled
+//	from before the lock is released, so there is nothing to
+//	allocate, and no chance the waiter will miss the signal.
 //
 //	Note: we assume Mesa-style semantics, which means that the
 //	waiter must re-acquire the monitor lock when waking up.
@@ -263,16 +264,18 @@ Condition::getName()
 
 void Condition::Wait(Lock* conditionLock) 
 {
-     Semaphore *waiter;
+     Interrupt *interrupt = kernel->interrupt;
+     Thread *waiter = kernel->currentThread;
+     IntStatus oldLevel;
     
      ASSERT(conditionLock->IsHeldByCurrentThread());
 
-     waiter = new Semaphore("condition", 0);
-     waitQueue->Append(waiter);
+     oldLevel = interrupt->SetLevel(IntOff);
+     waitQueue.Append(waiter);
      conditionLock->Release();
-     waiter->P();
+     waiter->Sleep(FALSE);
+     (void) interrupt->SetLevel(oldLevel);
      conditionLock->Acquire();
-     delete waiter;
 }
 
 //----------------------------------------------------------------------
@@ -292,13 +295,15 @@ void Condition::Wait(Lock* conditionLock)
 
 void Condition::Signal(Lock* conditionLock)
 {
-    Semaphore *waiter;
+    Interrupt *interrupt = kernel->interrupt;
+    IntStatus oldLevel;
     
     ASSERT(conditionLock->IsHeldByCurrentThread());
     
-    if (!waitQueue->IsEmpty()) {
-        waiter = waitQueue->RemoveFront();
-	waiter->V();
+    if (!waitQueue.IsEmpty()) {
+	oldLevel = interrupt->SetLevel(IntOff);
+	kernel->scheduler->ReadyToRun(waitQueue.RemoveFront());
+	(void) interrupt->SetLevel(oldLevel);
     }
 }
 
@@ -311,7 +316,7 @@ void Condition::Signal(Lock* conditionLock)
 
 void Condition::Broadcast(Lock* conditionLock) 
 {
-    while (!waitQueue->IsEmpty()) {
+    while (!waitQueue.IsEmpty()) {
         Signal(conditionLock);
     }
 }
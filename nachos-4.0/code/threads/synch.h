@@ -50,8 +50,7 @@ class Semaphore {
   private:
     char* name;        // useful for debugging
     int value;         // semaphore value, always >= 0
-    List<Thread *> *queue;     
-		  	// threads waiting in P() for the value to be > 0
+    ThreadQueue queue;	// threads waiting in P() for the value to be > 0
    };
 
 // The following class defines a "lock".  A lock can be BUSY or FREE.
@@ -138,6 +137,7 @@ class Condition {
 
   private:
     char* name;
-    List<Semaphore *> *waitQueue;	// list of waiting threads
+    IntrusiveList<Thread, &Thread::waitLink> waitQueue;
+					// list of waiting threads
 };
 #endif // SYNCH_H
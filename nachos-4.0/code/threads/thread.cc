@@ -25,6 +25,19 @@
 // this is put at the top of the execution stack, for detecting stack overflows
 const int STACK_FENCEPOST = 0xdedbeef;
 
+// The stacks and Thread objects of finished threads, kept for new
+// threads to reuse: allocating a stack takes two mprotect calls, and
+// freeing it two more.  Each one in a pool holds a pointer to the next.
+static int poolLimit = DefaultPoolLimit;
+static void *freeStacks = NULL;
+static int numFreeStacks = 0;
+static void *freeThreads = NULL;
+static int numFreeThreads = 0;
+
+// The threads that have a stack of their own, so that the memory
+// committed to the stacks of those still alive at halt gets counted.
+static IntrusiveList<Thread, &Thread::liveLink> liveThreads;
+
 //----------------------------------------------------------------------
 // Thread::Thread
 // 	Initialize a thread control block, so that we can then call
@@ -38,7 +51,20 @@ Thread::Thread(char* threadName)
     name = threadName;
     stackTop = NULL;
     stack = NULL;
+    stackSize = 0;
     status = JUST_CREATED;
+    priority = DefaultPriority;
+    tickets = DefaultTickets;
+    queueLevel = 0;
+    quantumUsed = 0;
+    boostsSeen = 0;
+    readySince = 0;
+    burstEstimate = 0;
+    burstUsed = 0;
+    readyIndex = -1;
+    readyOrder = 0;
+    pass = 0;
+    share = NULL;
     for (int i = 0; i < MachineStateSize; i++) {
 	machineState[i] = NULL;		// not strictly necessary, since
 					// new thread ignores contents 
@@ -66,8 +92,147 @@ Thread::~Thread()
     DEBUG(dbgThread, "Deleting thread: " << name);
 
     ASSERT(this != kernel->currentThread);
-    if (stack != NULL)
-	DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
+    if (stack != NULL) {
+	SampleStack();
+	liveThreads.Remove(this);
+	if (stackSize == StackSize && numFreeStacks < poolLimit) {
+	    // give back what it touched, so that the next thread to
+	    // get it doesn't start out with it committed
+	    DecommitStack((char *) stack, stackSize * sizeof(int));
+	    *(void **) stack = freeStacks;	// keep it for the next one
+	    freeStacks = stack;
+	    numFreeStacks++;
+	} else
+	    DeallocStack((char *) stack, stackSize * sizeof(int));
+    }
+}
+
+//----------------------------------------------------------------------
+// Thread::operator new
+// 	Allocate memory for a Thread object: that of a finished one,
+//	if there is any in the pool.
+//----------------------------------------------------------------------
+
+void *
+Thread::operator new(size_t size)
+{
+    void *p;
+
+    ASSERT(size == sizeof(Thread));
+    if (freeThreads == NULL) {
+	kernel->stats->numThreadMisses++;
+	return ::operator new(size);
+    }
+    kernel->stats->numThreadHits++;
+    p = freeThreads;
+    freeThreads = *(void **) p;
+    numFreeThreads--;
+    return p;
+}
+
+//----------------------------------------------------------------------
+// Thread::operator delete
+// 	Free the memory of a Thread object that has been deleted: keep
+//	it in the pool, unless the pool is full.
+//----------------------------------------------------------------------
+
+void
+Thread::operator delete(void *p)
+{
+    if (numFreeThreads < poolLimit) {
+	*(void **) p = freeThreads;
+	freeThreads = p;
+	numFreeThreads++;
+    } else
+	::operator delete(p);
+}
+
+//----------------------------------------------------------------------
+// Thread::SetPoolLimit
+// 	Keep at most "n" stacks, and as many Thread objects, of finished
+//	threads for new ones to reuse; free any more there are now.
+//----------------------------------------------------------------------
+
+void
+Thread::SetPoolLimit(int n)
+{
+    void *p;
+
+    ASSERT(n >= 0);
+    poolLimit = n;
+    while (numFreeStacks > n) {
+	p = freeStacks;
+	freeStacks = *(void **) p;
+	numFreeStacks--;
+	DeallocStack((char *) p, StackSize * sizeof(int));
+    }
+    while (numFreeThreads > n) {
+	p = freeThreads;
+	freeThreads = *(void **) p;
+	numFreeThreads--;
+	::operator delete(p);
+    }
+}
+
+//----------------------------------------------------------------------
+// Thread::SampleStack
+// 	Note how much host memory is committed to this thread's stack,
+//	in case it's the most any has had.
+//----------------------------------------------------------------------
+
+void
+Thread::SampleStack()
+{
+    int committed = StackCommitted((char *) stack, stackSize * sizeof(int));
+
+    DEBUG(dbgThread, "Thread " << name << " committed " << committed
+	    << " bytes of its " << stackSize * sizeof(int) << " byte stack");
+    if (committed > kernel->stats->maxStackCommitted)
+	kernel->stats->maxStackCommitted = committed;
+}
+
+//----------------------------------------------------------------------
+// Thread::SampleStacks
+// 	Sample the stack of every thread still alive; called at halt,
+//	since the stacks of the others were sampled as they were deleted.
+//----------------------------------------------------------------------
+
+void
+Thread::SampleStacks()
+{
+    IntrusiveListIterator<Thread, &Thread::liveLink> iter(&liveThreads);
+
+    for (; !iter.IsDone(); iter.Next())
+	iter.Item()->SampleStack();
+}
+
+//----------------------------------------------------------------------
+// Thread::setPriority
+// 	Set the thread's scheduling priority, from 0 (the highest) to
+//	NumPriorities - 1.  Only the priority scheduler uses it; it takes
+//	effect the next time the thread is put on the ready queue.
+//----------------------------------------------------------------------
+
+void
+Thread::setPriority(int p)
+{
+    ASSERT(p >= 0 && p < NumPriorities);
+    priority = p;
+}
+
+//----------------------------------------------------------------------
+// Thread::setTickets
+// 	Set how many tickets the thread holds.  Only the stride scheduler
+//	uses them: it gives each thread a share of the CPU in proportion.
+//	Takes effect from the next time the scheduler charges the thread
+//	for the CPU it has used.
+//----------------------------------------------------------------------
+
+void
+Thread::setTickets(int t)
+{
+    ASSERT(t > 0);
+    tickets = t;
 }
 
 //----------------------------------------------------------------------
@@ -88,17 +253,21 @@ Thread::~Thread()
 // 	
 //	"func" is the procedure to run concurrently.
 //	"arg" is a single argument to be passed to the procedure.
+//	"size" is how big its stack is, in words.  Host memory is only
+//		committed to the part of it that is used.
 //----------------------------------------------------------------------
 
 void 
-Thread::Fork(VoidFunctionPtr func, void *arg)
+Thread::Fork(VoidFunctionPtr func, void *arg, int size)
 {
     Interrupt *interrupt = kernel->interrupt;
     Scheduler *scheduler = kernel->scheduler;
     IntStatus oldLevel;
     
-    DEBUG(dbgThread, "Forking thread: " << name << " f(a): " << (int) func << " " << arg);
+    DEBUG(dbgThread, "Forking thread: " << name << " f(a): " << (void *) func << " " << arg);
     
+    ASSERT(size > 0);
+    stackSize = size;
     StackAllocate(func, arg);
 
     oldLevel = interrupt->SetLevel(IntOff);
@@ -127,7 +296,7 @@ Thread::CheckOverflow()
 {
     if (stack != NULL) {
 #ifdef HPUX			// Stacks grow upward on the Snakes
-	ASSERT(stack[StackSize - 1] == STACK_FENCEPOST);
+	ASSERT(stack[stackSize - 1] == STACK_FENCEPOST);
 #else
 	ASSERT(*stack == STACK_FENCEPOST);
 #endif
@@ -300,6 +469,9 @@ PLabelToAddr(void *plabel)
 //		calls (*func)(arg)
 //		calls Thread::Finish
 //
+//	The stack of a finished thread is reused, if there is one of the
+//	right size in the pool; it still has its guard pages.
+//
 //	"func" is the procedure to be forked
 //	"arg" is the parameter to be passed to the procedure
 //----------------------------------------------------------------------
@@ -307,34 +479,43 @@ PLabelToAddr(void *plabel)
 void
 Thread::StackAllocate (VoidFunctionPtr func, void *arg)
 {
-    stack = (int *) AllocBoundedArray(StackSize * sizeof(int));
+    if (stackSize == StackSize && freeStacks != NULL) {
+	kernel->stats->numStackHits++;
+	stack = (int *) freeStacks;
+	freeStacks = *(void **) freeStacks;
+	numFreeStacks--;
+    } else {
+	kernel->stats->numStackMisses++;
+	stack = (int *) AllocStack(stackSize * sizeof(int));
+    }
+    liveThreads.Append(this);
 
 #ifdef PARISC
     // HP stack works from low addresses to high addresses
     // everyone else works the other way: from high addresses to low addresses
     stackTop = stack + 16;	// HP requires 64-byte frame marker
-    stack[StackSize - 1] = STACK_FENCEPOST;
+    stack[stackSize - 1] = STACK_FENCEPOST;
 #endif
 
 #ifdef SPARC
-    stackTop = stack + StackSize - 96; 	// SPARC stack must contains at 
+    stackTop = stack + stackSize - 96; 	// SPARC stack must contains at 
 					// least 1 activation record 
 					// to start with.
     *stack = STACK_FENCEPOST;
 #endif 
 
 #ifdef PowerPC // RS6000
-    stackTop = stack + StackSize - 16; 	// RS6000 requires 64-byte frame marker
+    stackTop = stack + stackSize - 16; 	// RS6000 requires 64-byte frame marker
     *stack = STACK_FENCEPOST;
 #endif 
 
 #ifdef DECMIPS
-    stackTop = stack + StackSize - 4;	// -4 to be on the safe side!
+    stackTop = stack + stackSize - 4;	// -4 to be on the safe side!
     *stack = STACK_FENCEPOST;
 #endif
 
 #ifdef ALPHA
-    stackTop = stack + StackSize - 8;	// -8 to be on the safe side!
+    stackTop = stack + stackSize - 8;	// -8 to be on the safe side!
     *stack = STACK_FENCEPOST;
 #endif
 
@@ -343,10 +524,20 @@ Thread::StackAllocate (VoidFunctionPtr func, void *arg)
     // the x86 passes the return address on the stack.  In order for SWITCH() 
     // to go to ThreadRoot when we switch to this thread, the return addres 
     // used in SWITCH() must be the starting address of ThreadRoot.
-    stackTop = stack + StackSize - 4;	// -4 to be on the safe side!
+    stackTop = stack + stackSize - 4;	// -4 to be on the safe side!
     *(--stackTop) = (int) ThreadRoot;
     *stack = STACK_FENCEPOST;
 #endif
+
+#ifdef x86_64
+    // The same, but the return address is 8 bytes, and the stack must
+    // be 16-byte aligned at each call: so it is here, just before the
+    // return address is popped (see ThreadRoot).
+    stackTop = (int *) ((unsigned long) (stack + stackSize - 4) & ~0xfUL);
+    stackTop -= 4;
+    *(void **) stackTop = (void *) ThreadRoot;
+    *stack = STACK_FENCEPOST;
+#endif
     
 #ifdef PARISC
     machineState[PCState] = PLabelToAddr(ThreadRoot);
@@ -437,3 +628,42 @@ Thread::SelfTest()
     SimpleThread(0);
 }
 
+//----------------------------------------------------------------------
+// PingPong
+// 	Yield the CPU "n" times, to the other thread of the benchmark.
+//----------------------------------------------------------------------
+
+static void
+PingPong(int n)
+{
+    for (int i = 0; i < n; i++)
+        kernel->currentThread->Yield();
+}
+
+//----------------------------------------------------------------------
+// Thread::SwitchBenchmark
+// 	Measure how long a context switch takes on the host: SWITCH,
+//	and the rest of what Scheduler::Run does.  Two threads yield
+//	the CPU to each other, so that (but for the odd timer
+//	interrupt) each Yield switches to the other thread.
+//
+//	"switches" is how many context switches to time, at least 2;
+//	rounded down to an even number.
+//----------------------------------------------------------------------
+
+void
+Thread::SwitchBenchmark(int switches)
+{
+    Thread *t = new Thread("ping-pong thread");
+    double start, seconds;
+
+    ASSERT(switches >= 2);
+    switches -= switches % 2;
+    t->Fork((VoidFunctionPtr) PingPong, (void *) (long) (switches / 2));
+    start = HostTime();
+    PingPong(switches / 2);
+    seconds = HostTime() - start;
+    cout << "Context switch: " << switches << " switches in " << seconds
+	 << " host seconds, " << seconds * 1e9 / switches << " ns each\n";
+}
+
@@ -40,6 +40,8 @@
 #include "copyright.h"
 #include "utility.h"
 #include "sysdep.h"
+#include "stats.h"
+#include "list.h"
 
 #ifdef USER_PROGRAM
 #include "machine.h"
@@ -56,14 +58,31 @@
 #define MachineStateSize 75 
 
 
-// Size of the thread's private execution stack.
+// Size of the thread's private execution stack, unless it is given
+// another when it is forked.
 // WATCH OUT IF THIS ISN'T BIG ENOUGH!!!!!
 const int StackSize = (4 * 1024);	// in words
 
 
+// How many stacks, and Thread objects, of finished threads are kept
+// for new threads to reuse, unless told otherwise (Thread::SetPoolLimit).
+const int DefaultPoolLimit = 16;
+
 // Thread state
 enum ThreadStatus { JUST_CREATED, RUNNING, READY, BLOCKED };
 
+// Scheduling priorities, for schedulers that use them: 0 is the highest.
+// (At most 64 levels: the priority scheduler keeps a bit for each.)
+const int NumPriorities = 64;
+const int DefaultPriority = NumPriorities / 2;
+
+// Shares of the CPU, for the stride scheduler: a thread gets the CPU
+// in proportion to how many tickets it holds.
+const int DefaultTickets = 100;
+
+class StrideShare;
+class Semaphore;
+
 
 // The following class defines a "thread control block" -- which
 // represents a single thread of execution.
@@ -92,8 +111,9 @@ class Thread {
 
     // basic thread operations
 
-    void Fork(VoidFunctionPtr func, void *arg); 
-    				// Make thread run (*func)(arg)
+    void Fork(VoidFunctionPtr func, void *arg, int size = StackSize); 
+    				// Make thread run (*func)(arg), on a
+				// stack of "size" words
     void Yield();  		// Relinquish the CPU if any 
 				// other thread is runnable
     void Sleep(bool finishing); // Put the thread to sleep and 
@@ -103,9 +123,26 @@ class Thread {
     
     void CheckOverflow();   	// Check if thread stack has overflowed
     void setStatus(ThreadStatus st) { status = st; }
+    ThreadStatus getStatus() { return status; }
+    void setPriority(int p);	// 0 (highest) to NumPriorities - 1
+    int getPriority() { return priority; }
+    void setTickets(int t);	// at least 1
+    int getTickets() { return tickets; }
     char* getName() { return (name); }
     void Print() { cout << name; }
     void SelfTest();		// test whether thread impl is working
+    static void SwitchBenchmark(int switches);
+				// time context switches on the host
+
+    static void *operator new(size_t size);
+				// reuse a finished Thread, if any
+    static void operator delete(void *p);
+				// keep it for reuse, if there's room
+    static void SetPoolLimit(int n);
+				// keep at most n finished stacks and
+				// Threads; 0 to keep none
+    static void SampleStacks();	// note how much of the stack of each
+				// live thread is committed
 
   private:
     // some of the private data for this class is listed above
@@ -113,12 +150,50 @@ class Thread {
     int *stack; 	 	// Bottom of the stack 
 				// NULL if this is the main thread
 				// (If NULL, don't deallocate stack)
+    int stackSize;		// its size, in words
     ThreadStatus status;	// ready, running or blocked
     char* name;
+    int priority;		// scheduling priority, 0 is the highest
+    int tickets;		// share of the CPU, for the stride scheduler
+
+  public:
+    ListLink<Thread> queueLink;	// its place on the ready queue, or on
+				// the queue of a semaphore it waits on
+    ListLink<Thread> waitLink;	// its place on the queue of a condition
+				// it waits on
+    ListLink<Thread> liveLink;	// its place on the list of threads
+				// that have a stack
+
+				// for the multi-level feedback queue:
+    int queueLevel;		// the queue it belongs on
+    long long quantumUsed;	// time slices it has used of its
+				// quantum there
+    int boostsSeen;		// how many priority boosts it has been
+				// through; if fewer than the scheduler
+				// did, it belongs on the top queue
+    Ticks readySince;		// when it was last made ready
+
+				// for shortest job first:
+    Ticks burstEstimate;	// predicted length of its next CPU burst
+    Ticks burstUsed;		// CPU time used so far in the current one
+    int readyIndex;		// where it is on the ready heap; -1 if
+				// it isn't there
+    unsigned long long readyOrder; // when it was put there, so that
+				// threads with the same estimate run
+				// first come, first served
+
+				// for the stride scheduler:
+    long long pass;		// how far it has got: the CPU time it
+				// has had, divided by its tickets
+    StrideShare *share;		// what it got of the CPU, and what it
+				// was due; NULL until it is first ready
+
+  private:
 
     void StackAllocate(VoidFunctionPtr func, void *arg);
     				// Allocate a stack for thread.
 				// Used internally by Fork()
+    void SampleStack();		// note how much of its stack is committed
 
 #ifdef USER_PROGRAM
 // A thread running a user program actually has *two* sets of CPU registers -- 
@@ -135,6 +210,13 @@ class Thread {
 #endif
 };
 
+// A queue of threads -- the ready queue, or the threads waiting on a
+// semaphore -- linked through the threads themselves.  A thread is
+// never on more than one of them at a time.
+
+typedef IntrusiveList<Thread, &Thread::queueLink> ThreadQueue;
+typedef IntrusiveListIterator<Thread, &Thread::queueLink> ThreadQueueIterator;
+
 // external function, dummy routine whose sole job is to call Thread::Print
 extern void ThreadPrint(Thread *thread);	 
 
@@ -25,6 +25,10 @@
 #include "main.h"
 #include "syscall.h"
 
+// Write copies the user's buffer out through a kernel buffer this big,
+// a piece at a time, so that it never allocates memory.
+const int WriteChunk = 256;
+
 //----------------------------------------------------------------------
 // ExceptionHandler
 // 	Entry point into the Nachos kernel.  Called when a user program
@@ -65,6 +69,28 @@ ExceptionHandler(ExceptionType which)
 			val=kernel->machine->ReadRegister(4);
 			cout << "Print integer:" <<val << endl;
 			return;
+		case SC_Write:
+		    {
+			int buffer = kernel->machine->ReadRegister(4);
+			int size = kernel->machine->ReadRegister(5);
+			int file = kernel->machine->ReadRegister(6);
+			char data[WriteChunk];
+			int n;
+
+			if (file != ConsoleOutput) {
+			    DEBUG(dbgAddr, "Write to unknown file " << file);
+			    return;
+			}
+			for (; size > 0; buffer += n, size -= n) {
+			    n = min(size, WriteChunk);
+			    if (!kernel->currentThread->space->CopyIn(buffer, data, n)) {
+				DEBUG(dbgAddr, "Write from a bad buffer " << buffer);
+				return;
+			    }
+			    cout.write(data, n);
+			}
+			return;
+		    }
 /*		case SC_Exec:
 			DEBUG(dbgAddr, "Exec\n");
 			val = kernel->machine->ReadRegister(4);
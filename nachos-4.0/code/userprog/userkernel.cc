@@ -21,6 +21,8 @@ UserProgKernel::UserProgKernel(int argc, char **argv)
 		: ThreadedKernel(argc, argv)
 {
     debugUserProg = FALSE;
+    simulatorType = Interpreter;
+    profileFile = NULL;
 	execfileNum=0;
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-s") == 0) {
@@ -28,20 +30,75 @@ UserProgKernel::UserProgKernel(int argc, char **argv)
 	}
 	else if (strcmp(argv[i], "-e") == 0) {
 		execfile[++execfileNum]= argv[++i];
+		execPriority[execfileNum] = DefaultPriority;
+		execTickets[execfileNum] = DefaultTickets;
+	}
+	else if (strcmp(argv[i], "-ep") == 0) {
+	    ASSERT(i + 2 < argc);
+		execfile[++execfileNum]= argv[++i];
+		execPriority[execfileNum] = atoi(argv[++i]);
+		execTickets[execfileNum] = DefaultTickets;
+	}
+	else if (strcmp(argv[i], "-et") == 0) {
+	    ASSERT(i + 2 < argc);
+		execfile[++execfileNum]= argv[++i];
+		execPriority[execfileNum] = DefaultPriority;
+		execTickets[execfileNum] = atoi(argv[++i]);
+	}
+	else if (strcmp(argv[i], "-bb") == 0) {
+	    simulatorType = BlockInterpreter;
+	}
+	else if (strcmp(argv[i], "-jit") == 0) {
+	    simulatorType = BinaryTranslation;
+	}
+	else if (strcmp(argv[i], "-prof") == 0) {
+	    ASSERT(i + 1 < argc);
+	    profileFile = argv[++i];
+	}
+	else if (strcmp(argv[i], "-mem") == 0) {
+	    ASSERT(i + 1 < argc);
+	    int n = atoi(argv[++i]);
+	    if (n <= 0)
+		cout << "-mem needs at least 1 page; ignored" << endl;
+	    else
+		NumPhysPages = n;
+	}
+	else if (strcmp(argv[i], "-pagesize") == 0) {
+	    ASSERT(i + 1 < argc);
+	    int n = atoi(argv[++i]);
+	    if (n <= 0 || n % 4 != 0)
+		cout << "-pagesize needs a positive multiple of 4; ignored" << endl;
+	    else
+		PageSize = n;
 	}
     	 else if (strcmp(argv[i], "-u") == 0) {
 		cout << "===========The following argument is defined in userkernel.cc" << endl;
 		cout << "Partial usage: nachos [-s]\n";
 		cout << "Partial usage: nachos [-u]" << endl;
 		cout << "Partial usage: nachos [-e] filename" << endl;
+		cout << "Partial usage: nachos [-ep] filename priority" << endl;
+		cout << "Partial usage: nachos [-et] filename tickets" << endl;
+		cout << "Partial usage: nachos [-bb]" << endl;
+		cout << "Partial usage: nachos [-jit]" << endl;
+		cout << "Partial usage: nachos [-prof] filename" << endl;
+		cout << "Partial usage: nachos [-mem] pages" << endl;
+		cout << "Partial usage: nachos [-pagesize] bytes" << endl;
 	}
 	else if (strcmp(argv[i], "-h") == 0) {
 		cout << "argument 's' is for debugging. Machine status  will be printed " << endl;
 		cout << "argument 'e' is for execting file." << endl;
+		cout << "argument 'ep' is for execting file at a priority, from 0 (highest) to " << NumPriorities - 1 << " (default " << DefaultPriority << "); see -PRIORITY." << endl;
+		cout << "argument 'bb' runs user programs a basic block at a time (faster, same results)." << endl;
+		cout << "argument 'jit' translates hot user code into x86-64 code (fastest, same results)." << endl;
+		cout << "argument 'prof' counts every user instruction, prints the hot spots at halt and writes all counts to filename." << endl;
+		cout << "argument 'mem' sets how many pages of physical memory the machine has (default " << DefaultNumPhysPages << ")." << endl;
+		cout << "argument 'pagesize' sets how many bytes are in a page (default " << DefaultPageSize << ")." << endl;
 		cout << "atgument 'u' will print all argument usage." << endl;
 		cout << "For example:" << endl;
 		cout << "	./nachos -s : Print machine status during the machine is on." << endl;
 		cout << "	./nachos -e file1 -e file2 : executing file1 and file2."  << endl;
+		cout << "	./nachos -bb -e file1 : executing file1 with the basic block simulator."  << endl;
+		cout << "	./nachos -mem 16 -e file1 : executing file1 with 16 pages of memory."  << endl;
 	}
     }
 }
@@ -56,7 +113,9 @@ UserProgKernel::Initialize()
 {
     ThreadedKernel::Initialize();	// init multithreading
 
-    machine = new Machine(debugUserProg);
+    machine = new Machine(debugUserProg, simulatorType);
+    if (profileFile != NULL)
+	machine->StartProfiling(profileFile);
     fileSystem = new FileSystem();
 #ifdef FILESYS
     synchDisk = new SynchDisk("New SynchDisk");
@@ -96,6 +155,8 @@ UserProgKernel::Run()
 	for (int n=1;n<=execfileNum;n++)
 		{
 		t[n] = new Thread(execfile[n]);
+		t[n]->setPriority(execPriority[n]);
+		t[n]->setTickets(execTickets[n]);
 		t[n]->space = new AddrSpace();
 		t[n]->Fork((VoidFunctionPtr) &ForkExecute, (void *)t[n]);
 		cout << "Thread " << execfile[n] << " is executing." << endl;
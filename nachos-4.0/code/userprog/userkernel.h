@@ -39,8 +39,12 @@ class UserProgKernel : public ThreadedKernel {
 
   private:
     bool debugUserProg;		// single step user program
+    SimulatorType simulatorType; // how the machine runs user instructions
+    char *profileFile;		// where to write the profile, or NULL
 	Thread* t[10];
 	char*	execfile[10];
+	int	execPriority[10];	// the priority to run each file at
+	int	execTickets[10];	// and its tickets, for stride scheduling
 	int	execfileNum;
 };
 